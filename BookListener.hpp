@@ -0,0 +1,78 @@
+#pragma once
+
+#include <utility>
+
+#include "Using.hpp"
+#include "Order.hpp"
+#include "PriceLevel.hpp"
+#include "Trade.hpp"
+
+/**
+ * @struct BookListener
+ * @brief No-op set of book event hooks, called inline by BasicOrderbook.
+ *
+ * A listener derives from this and redeclares only the hooks it cares about. The book
+ * calls the hooks on its concrete listener type, so the calls are resolved at compile
+ * time and the empty ones vanish. Hooks run on the thread mutating the book, with the
+ * book's lock held where it takes one, and must not call back into the book.
+ */
+struct BookListener{
+    /**
+     * @brief An order now rests in the book: what was left of it after trading on arrival.
+     * Orders filled on arrival, and Fill-And-Kill remainders, never rest and are not reported here.
+     * @param order The resting order.
+     */
+    void OnOrderAdded([[maybe_unused]] const Order& order) { }
+
+    /**
+     * @brief A resting order left the book without being filled: cancelled or expired.
+     * @param order The order, with the quantity it still had.
+     */
+    void OnOrderCancelled([[maybe_unused]] const Order& order) { }
+
+    /**
+     * @brief A resting order was modified in place, before any matching the modify causes.
+     * @param order The order with its new side, price and quantity.
+     * @param keptPriority True if it kept its place in the queue, false if it went to the back of its level.
+     */
+    void OnOrderModified([[maybe_unused]] const Order& order, [[maybe_unused]] bool keptPriority) { }
+
+    /**
+     * @brief A bid and an ask traded.
+     * @param trade Both sides of the trade.
+     */
+    void OnTrade([[maybe_unused]] const Trade& trade) { }
+
+    /**
+     * @brief The aggregates of a price level changed.
+     * @param side Side of the level.
+     * @param price Price of the level.
+     * @param data New aggregates; a count_ of zero means the level is gone.
+     */
+    void OnLevelChanged([[maybe_unused]] Side side, [[maybe_unused]] Price price, [[maybe_unused]] const LevelData& data) { }
+};
+
+/**
+ * @class TradeCollector
+ * @brief Listener that appends trades to a buffer, backing the Trades-returning Orderbook API.
+ *
+ * Single-writer drivers clear and reuse the buffer between commands, so it stops
+ * allocating once it has grown to the largest sweep seen.
+ */
+class TradeCollector : public BookListener{
+public:
+    void OnTrade(const Trade& trade) { trades_.push_back(trade); }
+
+    /**
+     * @brief Trades collected since the buffer was last cleared or taken.
+     */
+    Trades& GetTrades() { return trades_; }
+
+    /**
+     * @brief Moves the collected trades out, leaving the buffer empty.
+     */
+    Trades TakeTrades() { return std::exchange(trades_, Trades{ }); }
+
+private:
+    Trades trades_;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <functional>
+
+#include "Using.hpp"
+#include "Side.hpp"
+
+/**
+ * @struct SideTraits
+ * @brief What differs between the bid and ask halves of the book, resolved at compile time.
+ *
+ * The book dispatches on an order's side once per call and runs code specialised on these
+ * traits from there, so the per-side ordering and crossing tests carry no runtime branch.
+ *
+ * @tparam S Side of the resting orders.
+ */
+template <Side S>
+struct SideTraits;
+
+template <>
+struct SideTraits<Side::Buy>{
+    using Compare = std::greater<Price>;      ///< Bids rank highest price first.
+    static constexpr Side Opposite = Side::Sell;
+
+    /**
+     * @brief Whether a buy limited at price trades with an ask resting at restingPrice.
+     */
+    static constexpr bool Crosses(Price price, Price restingPrice) { return price >= restingPrice; }
+};
+
+template <>
+struct SideTraits<Side::Sell>{
+    using Compare = std::less<Price>;         ///< Asks rank lowest price first.
+    static constexpr Side Opposite = Side::Buy;
+
+    /**
+     * @brief Whether a sell limited at price trades with a bid resting at restingPrice.
+     */
+    static constexpr bool Crosses(Price price, Price restingPrice) { return price <= restingPrice; }
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Using.hpp"
+#include "Trade.hpp"
+
+/**
+ * @struct BookSummary
+ * @brief Top of book and totals as of one published book state, read without the book's lock.
+ *
+ * The best price and quantity of a side are meaningless while its level count is zero.
+ */
+struct BookSummary{
+    std::uint64_t version_{ };       ///< Number of states published so far; grows with every applied command.
+    Price bestBid_{ };
+    Quantity bestBidQuantity_{ };
+    Price bestAsk_{ };
+    Quantity bestAskQuantity_{ };
+    std::uint32_t bidLevels_{ };
+    std::uint32_t askLevels_{ };
+    std::uint64_t orders_{ };        ///< Resting orders.
+    std::uint64_t trades_{ };        ///< Trades since the book was created.
+    TradeInfo lastBidTrade_{ };      ///< Bid side of the latest trade.
+    TradeInfo lastAskTrade_{ };      ///< Ask side of the latest trade.
+};
@@ -59,7 +59,21 @@ public:
      * @return A shared pointer to an Order obj with the same attributes as          * OrderModify.
      */
     OrderPointer ToOrderPointer(OrderType type) const{
-        return std::make_shared<Order>(type, GetOrderId(), GetSide(), GetPrice(), GetQuantity());
+        return std::make_shared<Order>(ToOrder(type));
+    }
+
+    /**
+     * @brief Converts this OrderModify obj to an Order obj by value.
+     * 
+     * Used by the book itself so that a modify never touches the heap.
+     * 
+     * @param type The type of the order (example: limit, market).
+     * @param expiry Expiry carried over from the order being replaced.
+     * 
+     * @return An Order obj with the same attributes as OrderModify.
+     */
+    Order ToOrder(OrderType type, Timestamp expiry = { }) const{
+        return Order{ type, GetOrderId(), GetSide(), GetPrice(), GetQuantity(), expiry };
     }
 
 private:
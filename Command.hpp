@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Using.hpp"
+#include "OrderTypes.hpp"
+#include "Side.hpp"
+#include "Order.hpp"
+#include "Change.hpp"
+#include "ExpiryWheel.hpp"
+
+/**
+ * @enum CommandType
+ * @brief Operations that can be applied to an order book.
+ */
+enum class CommandType{
+    Add,    ///< Add a new order.
+    Modify, ///< Replace price, side and quantity of a resting order.
+    Cancel, ///< Remove a resting order.
+    MassCancel, ///< Remove every resting order of one side.
+};
+
+/**
+ * @enum CommandStatus
+ * @brief Outcome of applying a command to an order book.
+ */
+enum class CommandStatus{
+    Accepted,         ///< The command was applied.
+    DuplicateOrderId, ///< An order with the same id already rests in the book.
+    UnknownOrderId,   ///< No resting order has the given id.
+    NoLiquidity,      ///< Market or Fill-And-Kill order with nothing to match against.
+    CannotFullyFill,  ///< Fill-Or-Kill order the book cannot fill completely.
+    UnknownInstrument, ///< No book is registered for the instrument the command was routed to.
+    AlreadyExpired,   ///< Good-Till-Date or Good-For-Day order whose expiry has already passed.
+    InvalidMessage,   ///< Protocol message that failed validation.
+    InvalidDisplayQuantity, ///< Iceberg order whose display quantity is zero or above its quantity.
+    InvalidQuantity,  ///< New order or modify with a quantity of zero; a cancel removes an order.
+    MissingExpiry,    ///< Good-Till-Date order without an expiry.
+};
+
+/**
+ * @brief Checks the display quantity of an Iceberg order: at least one, and no more than the order.
+ * @param displayQuantity Slice size of the order.
+ * @param quantity Total quantity of the order.
+ * @return True / false.
+ */
+inline bool IsValidDisplayQuantity(std::uint64_t displayQuantity, Quantity quantity){
+    return displayQuantity != 0 && displayQuantity <= quantity;
+}
+
+/**
+ * @struct Command
+ * @brief A single book operation in value form, so it can be queued, batched or journaled.
+ *
+ * Fields that an operation does not use are ignored (e.g. a cancel only reads orderId_,
+ * a mass cancel only side_).
+ */
+struct Command{
+    CommandType type_{ CommandType::Add };
+    OrderType orderType_{ OrderType::GoodTillCancel };
+    OrderId orderId_{ };
+    Side side_{ Side::Buy };
+    Price price_{ };
+    Quantity quantity_{ };
+    Timestamp expiry_{ };   ///< Expiry of GoodTillDate orders.
+    Quantity displayQuantity_{ }; ///< Slice size of Iceberg orders.
+
+    /**
+     * @brief Command adding an order.
+     * @param order The order to add.
+     */
+    static Command Add(const Order& order){
+        return Command{ CommandType::Add, order.GetOrderType(), order.GetOrderId(), order.GetSide(), order.GetPrice(), order.GetInitialQuantity(), order.GetExpiry(), order.GetDisplayQuantity() };
+    }
+
+    /**
+     * @brief Command replacing a resting order.
+     * @param order Order mod. details.
+     */
+    static Command Modify(const OrderModify& order){
+        return Command{ CommandType::Modify, OrderType::GoodTillCancel, order.GetOrderId(), order.GetSide(), order.GetPrice(), order.GetQuantity() };
+    }
+
+    /**
+     * @brief Command cancelling a resting order.
+     * @param orderId Id of the order.
+     */
+    static Command Cancel(OrderId orderId){
+        return Command{ CommandType::Cancel, OrderType::GoodTillCancel, orderId };
+    }
+
+    /**
+     * @brief Command cancelling every resting order of a side.
+     * @param side Side to clear.
+     */
+    static Command MassCancel(Side side){
+        return Command{ CommandType::MassCancel, OrderType::GoodTillCancel, 0, side };
+    }
+};
+
+using Commands = std::vector<Command>;
+
+/**
+ * @brief Checks a command against the rules every entry point shares: the book before applying
+ * it, and Decode before turning a protocol message into it.
+ *
+ * New orders and modifies need a quantity, Good-Till-Date orders an expiry after the epoch,
+ * and Iceberg orders a display quantity within their quantity.
+ * @param command The command.
+ * @return Accepted, or why the command is invalid.
+ */
+inline CommandStatus ValidateCommand(const Command& command){
+    if (command.type_ == CommandType::Modify)
+        return command.quantity_ == 0 ? CommandStatus::InvalidQuantity : CommandStatus::Accepted;
+    if (command.type_ != CommandType::Add)
+        return CommandStatus::Accepted;
+    if (command.quantity_ == 0)
+        return CommandStatus::InvalidQuantity;
+    if (command.orderType_ == OrderType::GoodTillDate && ExpiryWheel::ToTick(command.expiry_) == 0)
+        return CommandStatus::MissingExpiry;
+    if (command.orderType_ == OrderType::Iceberg && !IsValidDisplayQuantity(command.displayQuantity_, command.quantity_))
+        return CommandStatus::InvalidDisplayQuantity;
+    return CommandStatus::Accepted;
+}
@@ -0,0 +1,47 @@
+#include "CommandFile.hpp"
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CommandFileReader::CommandFileReader(const std::filesystem::path& path){
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot open command file");
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0){
+        const auto error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot stat command file");
+    }
+
+    // An empty file cannot be mapped, and has nothing to parse
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ == 0){
+        ::close(fd);
+        return;
+    }
+
+    mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    const auto error = errno;
+    ::close(fd);
+    if (mapping_ == MAP_FAILED){
+        mapping_ = nullptr;
+        throw std::system_error(error, std::generic_category(), "Cannot map command file");
+    }
+
+    // Parsed once, front to back
+    ::madvise(mapping_, size_, MADV_SEQUENTIAL);
+    ::madvise(mapping_, size_, MADV_WILLNEED);
+    data_ = static_cast<const char*>(mapping_);
+}
+
+CommandFileReader::~CommandFileReader(){
+    if (mapping_)
+        ::munmap(mapping_, size_);
+}
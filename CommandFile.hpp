@@ -0,0 +1,251 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Command.hpp"
+
+/**
+ * @struct CommandFileResult
+ * @brief Expected book state from the result line ("R orders bids asks") that ends a test file.
+ */
+struct CommandFileResult{
+    std::size_t allCount_;
+    std::size_t bidCount_;
+    std::size_t askCount_;
+};
+
+/**
+ * @class CommandFileReader
+ * @brief Streaming parser for text command files, reading them in place from a memory mapping.
+ *
+ * Lines are "A side type price quantity id" (with the display quantity appended for an
+ * Iceberg), "M id side price quantity", "C id" and an optional final "R orders bids asks". The mapping is classified 64 bytes at a time into
+ * separator and newline bitmasks (SSE2 where available), tokens are cut out of the mapping
+ * as string views and numbers are parsed with std::from_chars, so nothing is copied or
+ * allocated per line. Each command is handed to a sink as soon as its line is parsed.
+ */
+class CommandFileReader{
+public:
+    /**
+     * @param path Command file.
+     * @throws std::system_error if the file cannot be opened or mapped.
+     */
+    explicit CommandFileReader(const std::filesystem::path& path);
+
+    CommandFileReader(const CommandFileReader&) = delete;
+    void operator=(const CommandFileReader&) = delete;
+    CommandFileReader(CommandFileReader&&) = delete;
+    void operator=(CommandFileReader&&) = delete;
+    ~CommandFileReader();
+
+    /**
+     * @brief The whole file.
+     */
+    std::string_view Text() const { return { data_, size_ }; }
+
+    /**
+     * @brief Parses the file front to back.
+     * @param sink Called as sink(command) for each command line, in order; may apply it to a
+     * book directly or submit it to a bounded queue such as an OrderbookPipeline.
+     * @return The result line, if the file ends with one.
+     * @throws std::logic_error on a malformed line, or content after the result line.
+     */
+    template <typename Sink>
+    std::optional<CommandFileResult> Parse(Sink&& sink) const;
+
+private:
+    static constexpr std::size_t BlockSize = 64;
+    static constexpr std::size_t MaxTokens = 8;
+
+    using Tokens = std::array<std::string_view, MaxTokens>;
+
+    /**
+     * @brief Bitmasks of the bytes of one block that end a token, and of those that end a line.
+     */
+    struct BlockMasks{
+        std::uint64_t separators_;
+        std::uint64_t newlines_;
+    };
+
+    static BlockMasks Classify(const char* block);
+
+    template <typename Sink>
+    static void ParseLine(std::string_view line, const Tokens& tokens, std::size_t count,
+        Sink& sink, std::optional<CommandFileResult>& result);
+
+    [[noreturn]] static void ThrowInvalid(std::string_view line){
+        throw std::logic_error("Invalid update: " + std::string{ line });
+    }
+
+    static std::uint64_t ToNumber(std::string_view token, std::string_view line){
+        std::int64_t value{ };
+        const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (error != std::errc{ } || end != token.data() + token.size())
+            ThrowInvalid(line);
+        if (value < 0)
+            throw std::logic_error("Value is below zero.");
+        return static_cast<std::uint64_t>(value);
+    }
+
+    static Side ToSide(std::string_view token){
+        if (token == "B")
+            return Side::Buy;
+        if (token == "S")
+            return Side::Sell;
+        throw std::logic_error("Unknown Side");
+    }
+
+    // Dispatches on length first: only one name has each length except FillOrKill/GoodForDay
+    static OrderType ToOrderType(std::string_view token){
+        switch (token.size()){
+            case 14: if (token == "GoodTillCancel") return OrderType::GoodTillCancel; break;
+            case 11: if (token == "FillAndKill") return OrderType::FillAndKill; break;
+            case 10:
+                if (token == "FillOrKill") return OrderType::FillOrKill;
+                if (token == "GoodForDay") return OrderType::GoodForDay;
+                break;
+            case 7: if (token == "Iceberg") return OrderType::Iceberg; break;
+            case 6: if (token == "Market") return OrderType::Market; break;
+        }
+        throw std::logic_error("Unknown OrderType");
+    }
+
+    const char* data_{ };
+    std::size_t size_{ };
+    void* mapping_{ };
+};
+
+// Bit i of separators_ is set when byte i ends a token (space, tab, CR or LF), of newlines_ when it is LF
+inline CommandFileReader::BlockMasks CommandFileReader::Classify(const char* block){
+    #if defined(__SSE2__)
+    const auto space = _mm_set1_epi8(' ');
+    const auto tab = _mm_set1_epi8('\t');
+    const auto carriage = _mm_set1_epi8('\r');
+    const auto newline = _mm_set1_epi8('\n');
+
+    std::uint64_t separators{ }, newlines{ };
+    for (std::size_t lane = 0; lane < BlockSize / 16; ++lane){
+        const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + lane * 16));
+        const auto isNewline = _mm_cmpeq_epi8(bytes, newline);
+        const auto isSeparator = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, carriage), isNewline));
+        separators |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(isSeparator))) << (lane * 16);
+        newlines |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(isNewline))) << (lane * 16);
+    }
+    return { separators, newlines };
+    #else
+    std::uint64_t separators{ }, newlines{ };
+    for (std::size_t index = 0; index < BlockSize; ++index){
+        const auto byte = block[index];
+        const std::uint64_t bit = std::uint64_t{ 1 } << index;
+        if (byte == '\n')
+            newlines |= bit;
+        if (byte == ' ' || byte == '\t' || byte == '\r' || byte == '\n')
+            separators |= bit;
+    }
+    return { separators, newlines };
+    #endif
+}
+
+template <typename Sink>
+std::optional<CommandFileResult> CommandFileReader::Parse(Sink&& sink) const{
+    std::optional<CommandFileResult> result;
+    Tokens tokens;
+    std::size_t count{ };
+    std::size_t tokenStart{ }, lineStart{ };
+
+    auto EndToken = [&](std::size_t position){
+        if (position == tokenStart)
+            return;
+        if (count == MaxTokens)
+            ThrowInvalid(Text().substr(lineStart, position - lineStart));
+        tokens[count++] = Text().substr(tokenStart, position - tokenStart);
+    };
+
+    auto EndLine = [&](std::size_t position){
+        if (count != 0){
+            if (result)
+                throw std::logic_error("Result must be at the end of the file only.");
+            ParseLine(Text().substr(lineStart, position - lineStart), tokens, count, sink, result);
+        }
+        count = 0;
+        lineStart = position + 1;
+    };
+
+    auto Scan = [&](std::size_t base, BlockMasks masks){
+        for (auto bits = masks.separators_; bits != 0; bits &= bits - 1){
+            const auto bit = static_cast<std::size_t>(std::countr_zero(bits));
+            const auto position = base + bit;
+            EndToken(position);
+            if ((masks.newlines_ >> bit) & 1)
+                EndLine(position);
+            tokenStart = position + 1;
+        }
+    };
+
+    std::size_t base{ };
+    for (; base + BlockSize <= size_; base += BlockSize)
+        Scan(base, Classify(data_ + base));
+
+    // The tail goes through the same path, zero padded
+    if (base < size_){
+        alignas(16) char block[BlockSize]{ };
+        std::memcpy(block, data_ + base, size_ - base);
+        Scan(base, Classify(block));
+    }
+
+    EndToken(size_);
+    EndLine(size_);
+    return result;
+}
+
+template <typename Sink>
+void CommandFileReader::ParseLine(std::string_view line, const Tokens& tokens, std::size_t count,
+    Sink& sink, std::optional<CommandFileResult>& result){
+    if (tokens[0].size() != 1)
+        ThrowInvalid(line);
+
+    switch (tokens[0][0]){
+        case 'A':{
+            if (count != 6 && count != 7)
+                ThrowInvalid(line);
+            const auto orderType = ToOrderType(tokens[2]);
+            if ((count == 7) != (orderType == OrderType::Iceberg))
+                ThrowInvalid(line);
+            sink(Command{ CommandType::Add, orderType, ToNumber(tokens[5], line), ToSide(tokens[1]),
+                static_cast<Price>(ToNumber(tokens[3], line)), static_cast<Quantity>(ToNumber(tokens[4], line)), Timestamp{ },
+                count == 7 ? static_cast<Quantity>(ToNumber(tokens[6], line)) : Quantity{ } });
+            return;
+        }
+        case 'M':
+            if (count != 5)
+                ThrowInvalid(line);
+            sink(Command{ CommandType::Modify, OrderType::GoodTillCancel, ToNumber(tokens[1], line), ToSide(tokens[2]),
+                static_cast<Price>(ToNumber(tokens[3], line)), static_cast<Quantity>(ToNumber(tokens[4], line)) });
+            return;
+        case 'C':
+            if (count != 2)
+                ThrowInvalid(line);
+            sink(Command::Cancel(ToNumber(tokens[1], line)));
+            return;
+        case 'R':
+            if (count != 4)
+                ThrowInvalid(line);
+            result = CommandFileResult{ ToNumber(tokens[1], line), ToNumber(tokens[2], line), ToNumber(tokens[3], line) };
+            return;
+    }
+    ThrowInvalid(line);
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Using.hpp"
+
+/**
+ * @class CompressedDepth
+ * @brief Quantity per price for prices with no fixed grid, with the total up to any price in O(log n).
+ *
+ * The prices seen are kept in a treap ordered best first, each node holding the total
+ * quantity of its subtree, so a change at a price, a new price and the total up to a
+ * limit all cost one walk from the root. Priorities are a hash of the node's slot, which
+ * keeps the tree balanced in expectation and the layout the same from run to run.
+ * Prices whose quantity went back to zero stay in the tree; they are dropped, and the
+ * tree rebuilt in O(n), when a new price arrives once they outnumber the live ones.
+ *
+ * @tparam Compare Order of the prices, best first: std::greater<Price> for bids, std::less<Price> for asks.
+ */
+template <typename Compare>
+class CompressedDepth{
+public:
+    CompressedDepth() : nodes_(1) { }
+
+    /**
+     * @brief Number of prices with a non-zero quantity.
+     */
+    std::size_t Size() const { return live_; }
+
+    /**
+     * @brief Changes the quantity at a price.
+     * @param price The price.
+     * @param delta Signed change of its quantity.
+     */
+    void Add(Price price, std::int64_t delta){
+        if (delta == 0)
+            return;
+
+        // Every node on the search path holds the price in its subtree, found or about to be
+        for (auto node = root_; node != Null; node = Compare{ }(price, nodes_[node].price_) ? nodes_[node].left_ : nodes_[node].right_){
+            nodes_[node].total_ += static_cast<std::uint64_t>(delta);
+            if (nodes_[node].price_ != price)
+                continue;
+
+            const auto before = nodes_[node].quantity_;
+            nodes_[node].quantity_ += static_cast<std::uint64_t>(delta);
+            if (before == 0)
+                ++live_;
+            else if (nodes_[node].quantity_ == 0)
+                --live_;
+            return;
+        }
+
+        if (nodes_.size() - 1 - live_ > live_ + MinStale){
+            Compact();
+            Add(price, delta);
+            return;
+        }
+        Insert(price, static_cast<std::uint64_t>(delta));
+        ++live_;
+    }
+
+    /**
+     * @brief Total quantity at prices at least as good as a limit.
+     * @param limit The limit price.
+     */
+    std::uint64_t SumTo(Price limit) const{
+        std::uint64_t quantity{ };
+        for (auto node = root_; node != Null; ){
+            const auto& entry = nodes_[node];
+            if (Compare{ }(limit, entry.price_)){
+                node = entry.left_;
+                continue;
+            }
+            quantity += nodes_[entry.left_].total_ + entry.quantity_;
+            node = entry.right_;
+        }
+        return quantity;
+    }
+
+private:
+    using Index = std::uint32_t;
+
+    struct Node{
+        Price price_{ };
+        std::uint64_t quantity_{ };
+        std::uint64_t total_{ };      ///< Quantity of the subtree rooted here.
+        std::uint64_t priority_{ };   ///< Heap order: a parent's priority is at least its children's.
+        Index left_{ };               ///< Better prices.
+        Index right_{ };              ///< Worse prices.
+    };
+
+    // splitmix64 finaliser: consecutive slots give unrelated priorities
+    static std::uint64_t PriorityOf(std::size_t slot){
+        auto value = static_cast<std::uint64_t>(slot) + 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    // Adds a price missing from the tree. The totals on the path down already include quantity,
+    // so only the subtree the new node takes over is split and summed again.
+    void Insert(Price price, std::uint64_t quantity){
+        const auto slot = static_cast<Index>(nodes_.size());
+        nodes_.push_back(Node{ .price_ = price, .quantity_ = quantity, .priority_ = PriorityOf(slot) });
+
+        auto* link = &root_;
+        while (*link != Null && nodes_[*link].priority_ >= nodes_[slot].priority_)
+            link = Compare{ }(price, nodes_[*link].price_) ? &nodes_[*link].left_ : &nodes_[*link].right_;
+
+        Index left{ }, right{ };
+        Split(*link, price, left, right);
+        nodes_[slot].left_ = left;
+        nodes_[slot].right_ = right;
+        nodes_[slot].total_ = nodes_[left].total_ + nodes_[right].total_ + quantity;
+        *link = slot;
+    }
+
+    // Splits a subtree into the prices better than price and the rest.
+    void Split(Index node, Price price, Index& left, Index& right){
+        if (node == Null){
+            left = right = Null;
+            return;
+        }
+        auto& entry = nodes_[node];
+        if (Compare{ }(entry.price_, price)){
+            Split(entry.right_, price, entry.right_, right);
+            left = node;
+        }else{
+            Split(entry.left_, price, left, entry.left_);
+            right = node;
+        }
+        nodes_[node].total_ = nodes_[nodes_[node].left_].total_ + nodes_[nodes_[node].right_].total_ + nodes_[node].quantity_;
+    }
+
+    // Drops the zero-quantity prices and rebuilds the tree from the live ones in O(n).
+    void Compact(){
+        std::vector<Node> live;
+        live.reserve(live_ + 1);
+        live.emplace_back();
+        std::vector<Index> path;
+        for (auto node = root_; node != Null || !path.empty(); ){
+            if (node != Null){
+                path.push_back(node);
+                node = nodes_[node].left_;
+                continue;
+            }
+            node = path.back();
+            path.pop_back();
+            if (nodes_[node].quantity_ != 0)
+                live.push_back(Node{ .price_ = nodes_[node].price_, .quantity_ = nodes_[node].quantity_ });
+            node = nodes_[node].right_;
+        }
+        nodes_.swap(live);
+
+        // Cartesian tree over the prices in order: each node pops the lower-priority ones off
+        // the right spine, whose subtrees are then complete and can be summed
+        path.clear();
+        for (Index slot = 1; slot < nodes_.size(); ++slot){
+            nodes_[slot].priority_ = PriorityOf(slot);
+            Index last{ };
+            while (!path.empty() && nodes_[path.back()].priority_ < nodes_[slot].priority_)
+                last = Close(path);
+            nodes_[slot].left_ = last;
+            if (!path.empty())
+                nodes_[path.back()].right_ = slot;
+            path.push_back(slot);
+        }
+        root_ = path.empty() ? Null : path.front();
+        while (!path.empty())
+            Close(path);
+    }
+
+    // Pops a finished node off the right spine and sums its subtree.
+    Index Close(std::vector<Index>& path){
+        const auto node = path.back();
+        path.pop_back();
+        auto& entry = nodes_[node];
+        entry.total_ = nodes_[entry.left_].total_ + nodes_[entry.right_].total_ + entry.quantity_;
+        return node;
+    }
+
+    static constexpr Index Null = 0;               ///< Slot 0 is an empty node with a total of zero.
+    static constexpr std::size_t MinStale = 64;    ///< Zero-quantity prices tolerated regardless of the live count.
+
+    std::vector<Node> nodes_;   ///< Every price held; slot 0 is Null.
+    Index root_{ Null };
+    std::size_t live_{ };
+};
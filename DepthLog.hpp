@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Using.hpp"
+#include "Side.hpp"
+#include "PriceLevel.hpp"
+
+/**
+ * @struct LevelChange
+ * @brief New aggregates of one price level after a book update.
+ */
+struct LevelChange{
+    std::uint64_t sequence_{ }; ///< Depth sequence of the update; increases by one per level change.
+    Side side_{ Side::Buy };
+    Price price_{ };
+    LevelData data_{ };         ///< A count_ of zero means the level is gone.
+};
+
+using LevelChanges = std::vector<LevelChange>;
+
+/**
+ * @class DepthLog
+ * @brief Bounded ring of the most recent level changes, for incremental depth publishing.
+ *
+ * Every level change gets the next depth sequence. A reader that knows the depth as of
+ * sequence X asks for the changes since X and applies them; if X has already been
+ * overwritten it takes a fresh snapshot instead.
+ */
+class DepthLog{
+public:
+    /**
+     * @param capacity Changes retained; rounded up to a power of two. Zero disables the log.
+     */
+    explicit DepthLog(std::size_t capacity)
+        : changes_(capacity == 0 ? 0 : std::bit_ceil(capacity))
+        , mask_{ changes_.empty() ? 0 : changes_.size() - 1 }
+    { }
+
+    /**
+     * @brief Sequence of the latest change; zero before any.
+     */
+    std::uint64_t Sequence() const { return sequence_; }
+
+    /**
+     * @brief Records the new aggregates of a level.
+     * @param side Side of the level.
+     * @param price Price of the level.
+     * @param data New aggregates.
+     */
+    void Record(Side side, Price price, const LevelData& data){
+        ++sequence_;
+        if (!changes_.empty())
+            changes_[sequence_ & mask_] = LevelChange{ sequence_, side, price, data };
+    }
+
+    /**
+     * @brief Collects the latest state of every level changed after a sequence.
+     * @param since Sequence the reader is up to date with.
+     * @param changes Cleared, then receives one entry per changed level, bids then asks, by price.
+     * @return The sequence the changes bring the reader up to, or nothing if the log no longer
+     * reaches back to since and the reader must take a snapshot.
+     */
+    std::optional<std::uint64_t> ChangesSince(std::uint64_t since, LevelChanges& changes) const{
+        changes.clear();
+        if (since > sequence_ || sequence_ - since > changes_.size())
+            return std::nullopt;
+
+        for (auto sequence = since + 1; sequence <= sequence_; ++sequence)
+            changes.push_back(changes_[sequence & mask_]);
+
+        // Keep only the last change of each level
+        std::stable_sort(changes.begin(), changes.end(), [](const LevelChange& left, const LevelChange& right){
+            return left.side_ != right.side_ ? left.side_ == Side::Buy : left.price_ < right.price_;
+        });
+        auto last = changes.begin();
+        for (auto change = changes.begin(); change != changes.end(); ++change){
+            const auto next = change + 1;
+            if (next == changes.end() || next->side_ != change->side_ || next->price_ != change->price_)
+                *last++ = *change;
+        }
+        changes.erase(last, changes.end());
+        return sequence_;
+    }
+
+private:
+    std::vector<LevelChange> changes_;
+    std::size_t mask_;
+    std::uint64_t sequence_{ };
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Orderbook.hpp"
+#include "ReferenceBook.hpp"
+#include "Journal.hpp"
+
+/**
+ * @brief Tick at which every fuzz stream starts, far past any real clock.
+ *
+ * Both books are moved to it before the first command and on by FuzzTicksPerCommand before each
+ * next one, so expiries in a stream fire at the same commands whenever and however often it runs.
+ * 4'102'444'800'000 ms is 2100-01-01T00:00:00Z.
+ */
+inline constexpr std::uint64_t FuzzEpochTick = 4'102'444'800'000;
+
+/**
+ * @brief Clock ticks between consecutive commands of a fuzz stream.
+ */
+inline constexpr std::uint64_t FuzzTicksPerCommand = 1;
+
+/**
+ * @struct FuzzConfig
+ * @brief Shape of the random command streams the differential fuzzer feeds both books.
+ *
+ * Prices are drawn from a narrow band around the mid, so most orders join or cross a level.
+ * Every order type (Iceberg slices smaller and larger than the order), duplicate and unknown
+ * ids, zero quantities, side-flipping modifies and mass cancels all occur. Good-Till-Date orders
+ * come without an expiry, already expired, due within a few hundred commands or not due in the
+ * stream; Good-For-Day orders mostly carry a session close halfway through it.
+ */
+struct FuzzConfig{
+    std::uint64_t seed_{ 1 };         ///< Same seed, same stream (with the same standard library).
+    std::size_t commands_{ 10'000 };  ///< Commands per stream.
+    Price midPrice_{ 1'000 };
+    Price priceRange_{ 16 };          ///< Furthest an order is placed from the mid, in ticks.
+    Quantity maxQuantity_{ 50 };
+};
+
+/**
+ * @brief Generates a reproducible random command stream.
+ * @param config Shape of the stream.
+ * @return The commands, in order.
+ */
+inline Commands GenerateFuzzCommands(const FuzzConfig& config){
+    using namespace std::chrono;
+
+    std::mt19937_64 random{ config.seed_ };
+    auto Chance = [&random](double probability){ return std::bernoulli_distribution{ probability }(random); };
+    auto Between = [&random](auto low, auto high){ return std::uniform_int_distribution<std::int64_t>(low, high)(random); };
+
+    struct Issued{
+        OrderId orderId_;
+        Side side_;
+        Price price_;
+    };
+    std::vector<Issued> issued;
+    OrderId nextId = 1;
+    const auto close = ExpiryWheel::ToTimestamp(FuzzEpochTick + config.commands_ / 2 * FuzzTicksPerCommand);
+
+    auto RandomSide = [&]{ return Chance(0.5) ? Side::Buy : Side::Sell; };
+    auto RandomPrice = [&]{ return static_cast<Price>(config.midPrice_ + Between(-config.priceRange_, config.priceRange_)); };
+    auto RandomQuantity = [&]{ return Chance(0.02) ? Quantity{ } : static_cast<Quantity>(Between(1, config.maxQuantity_)); };
+    // Mostly an order placed earlier, which may have traded or been cancelled since; sometimes one never placed
+    auto TargetOf = [&]() -> Issued{
+        if (issued.empty() || Chance(0.05))
+            return Issued{ nextId + 1'000'000, RandomSide(), RandomPrice() };
+        return issued[static_cast<std::size_t>(Between(0, static_cast<std::int64_t>(issued.size()) - 1))];
+    };
+
+    Commands commands;
+    commands.reserve(config.commands_);
+    while (commands.size() < config.commands_){
+        const auto roll = Between(0, 999);
+        if (roll < 500){
+            constexpr OrderType types[]{ OrderType::GoodTillCancel, OrderType::GoodTillCancel, OrderType::GoodTillCancel,
+                OrderType::FillAndKill, OrderType::FillOrKill, OrderType::GoodForDay, OrderType::Market, OrderType::GoodTillDate,
+                OrderType::Iceberg, OrderType::Iceberg };
+            const auto type = types[Between(0, std::size(types) - 1)];
+            const auto orderId = !issued.empty() && Chance(0.03) ? TargetOf().orderId_ : nextId++;
+            // The clock the command runs at, for expiries a little ahead of it
+            const auto now = ExpiryWheel::ToTimestamp(FuzzEpochTick + commands.size() * FuzzTicksPerCommand);
+            Timestamp expiry{ };
+            if (type == OrderType::GoodTillDate){
+                const auto kind = Between(0, 9);
+                expiry = kind == 0 ? Timestamp{ } : kind == 1 ? now - hours(1) : kind < 7 ? now + milliseconds(Between(1, 500) * FuzzTicksPerCommand) : now + hours(24);
+            }else if (type == OrderType::GoodForDay)
+                // Sometimes no close, which leaves the book to work out one from the real clock: long gone by the fuzz epoch
+                expiry = Chance(0.9) ? close : Timestamp{ };
+            // Slices from a few units to more than the whole order
+            const auto display = type != OrderType::Iceberg ? Quantity{ } : static_cast<Quantity>(Between(1, config.maxQuantity_ / 4 + 1));
+
+            const Issued order{ orderId, RandomSide(), RandomPrice() };
+            commands.push_back(Command{ CommandType::Add, type, order.orderId_, order.side_, order.price_, RandomQuantity(), expiry, display });
+            issued.push_back(order);
+        }else if (roll < 700){
+            commands.push_back(Command::Cancel(TargetOf().orderId_));
+        }else if (roll < 998){
+            // Same level (a cut or a raise), a new price, a flipped side, or anything
+            auto target = TargetOf();
+            const auto kind = Between(0, 9);
+            if (kind >= 4 && kind < 7)
+                target.price_ = RandomPrice();
+            else if (kind == 7)
+                target.side_ = target.side_ == Side::Buy ? Side::Sell : Side::Buy;
+            else if (kind > 7){
+                target.side_ = RandomSide();
+                target.price_ = RandomPrice();
+            }
+            commands.push_back(Command::Modify(OrderModify{ target.orderId_, target.side_, target.price_, RandomQuantity() }));
+            issued.push_back(target);
+        }else
+            commands.push_back(Command::MassCancel(RandomSide()));
+    }
+    return commands;
+}
+
+/**
+ * @brief One command in the text command-file notation, with the fields the notation lacks appended.
+ * @param command The command.
+ */
+inline std::string Describe(const Command& command){
+    constexpr const char* typeNames[]{ "GoodTillCancel", "FillAndKill", "FillOrKill", "GoodForDay", "Market", "GoodTillDate", "Iceberg" };
+    const char side = command.side_ == Side::Buy ? 'B' : 'S';
+
+    std::ostringstream text;
+    switch (command.type_){
+        case CommandType::Add:
+            text << "A " << side << ' ' << typeNames[static_cast<int>(command.orderType_)] << ' ' << command.price_ << ' '
+                 << command.quantity_ << ' ' << command.orderId_;
+            if (command.orderType_ == OrderType::GoodTillDate || command.expiry_ != Timestamp{ })
+                text << " expiry " << ExpiryWheel::ToTick(command.expiry_);
+            if (command.orderType_ == OrderType::Iceberg)
+                text << ' ' << command.displayQuantity_;
+            break;
+        case CommandType::Modify:
+            text << "M " << command.orderId_ << ' ' << side << ' ' << command.price_ << ' ' << command.quantity_;
+            break;
+        case CommandType::Cancel:
+            text << "C " << command.orderId_;
+            break;
+        case CommandType::MassCancel:
+            text << "X " << side;
+            break;
+    }
+    return text.str();
+}
+
+/**
+ * @struct DifferentialResult
+ * @brief Outcome of running one command stream through the reference and the optimised book.
+ */
+struct DifferentialResult{
+    std::size_t agreed_{ };                ///< Commands after which both books agreed.
+    std::optional<std::size_t> failure_;   ///< Length of the shortest prefix on which they differ, if any.
+    std::string reason_;                   ///< What differed after the last command of that prefix.
+
+    explicit operator bool() const { return !failure_; }
+};
+
+/**
+ * @brief Applies a stream to a ReferenceBook and an Orderbook side by side and compares them after every command.
+ *
+ * Before each command both books' clocks move to the tick it runs at, counted from FuzzEpochTick,
+ * and must expire the same number of orders. The status, every trade (both sides, in order) and
+ * the full level snapshot of both sides must then agree. Since the books are compared after each
+ * command, the first command on which they differ ends the shortest failing prefix.
+ * @param commands The stream.
+ * @param bookConfig Settings of the optimised book; its prune thread is always disabled.
+ * @return Where, if anywhere, the books diverged.
+ */
+inline DifferentialResult RunDifferential(std::span<const Command> commands, OrderbookConfig bookConfig = { }){
+    bookConfig.startPruneThread_ = false;
+    ReferenceBook reference;
+    Orderbook orderbook{ bookConfig };
+
+    DifferentialResult result;
+    Trades expected;
+    auto& actual = orderbook.GetListener().GetTrades();
+
+    auto SameTrade = [](const TradeInfo& lhs, const TradeInfo& rhs){
+        return lhs.orderId_ == rhs.orderId_ && lhs.price_ == rhs.price_ && lhs.quantity_ == rhs.quantity_;
+    };
+    auto SameLevels = [](const LevelInfos& lhs, const LevelInfos& rhs){
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const LevelInfo& left, const LevelInfo& right){
+            return left.price_ == right.price_ && left.quantity_ == right.quantity_;
+        });
+    };
+
+    for (const auto& command : commands){
+        const auto now = FuzzEpochTick + result.agreed_ * FuzzTicksPerCommand;
+        const auto expectedExpired = reference.Expire(now);
+        const auto actualExpired = orderbook.ExpireOrders(ExpiryWheel::ToTimestamp(now));
+
+        expected.clear();
+        actual.clear();
+        const auto expectedStatus = reference.Apply(command, expected);
+        const auto actualStatus = orderbook.ProcessCommand(command);
+
+        std::ostringstream reason;
+        if (expectedExpired != actualExpired)
+            reason << "expired " << actualExpired << " orders, expected " << expectedExpired;
+        else if (expectedStatus != actualStatus)
+            reason << "status " << static_cast<int>(actualStatus) << ", expected " << static_cast<int>(expectedStatus);
+        else if (expected.size() != actual.size())
+            reason << actual.size() << " trades, expected " << expected.size();
+        else{
+            for (std::size_t index = 0; index < expected.size(); ++index){
+                if (!SameTrade(expected[index].GetBidTrade(), actual[index].GetBidTrade()) || !SameTrade(expected[index].GetAskTrade(), actual[index].GetAskTrade())){
+                    reason << "trade " << index << " differs";
+                    break;
+                }
+            }
+        }
+
+        if (reason.tellp() == 0){
+            const auto infos = orderbook.GetOrderInfos();
+            if (!SameLevels(infos.GetBids(), reference.GetBids()))
+                reason << "bid levels differ";
+            else if (!SameLevels(infos.GetAsks(), reference.GetAsks()))
+                reason << "ask levels differ";
+            else if (orderbook.Size() != reference.Size())
+                reason << orderbook.Size() << " resting orders, expected " << reference.Size();
+        }
+
+        if (reason.tellp() != 0){
+            result.failure_ = result.agreed_ + 1;
+            result.reason_ = reason.str();
+            return result;
+        }
+        ++result.agreed_;
+    }
+    return result;
+}
+
+/**
+ * @brief Runs a stream through a journaled Orderbook, replays the journal into a fresh book and compares the two.
+ *
+ * The stream runs on the same clock as in RunDifferential, so its expiries are journaled too. Every
+ * record must replay, and the replayed book must hold the same levels and orders as the live one.
+ * The comparison is made once, at the end, so a failure is reported on the whole stream.
+ * @param commands The stream.
+ * @param bookConfig Settings of both books; the prune thread is always disabled and the journal replaced.
+ * @return Whether, and how, the replayed book differs.
+ */
+inline DifferentialResult RunJournalRoundTrip(std::span<const Command> commands, OrderbookConfig bookConfig = { }){
+    const auto path = std::filesystem::temp_directory_path() /
+        ("orderbook-fuzz-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".journal");
+    bookConfig.startPruneThread_ = false;
+
+    OrderbookLevelInfos live{ { }, { } };
+    std::size_t liveSize{ };
+    {
+        JournalWriter journal{ path, JournalConfig{ .sync_ = JournalSync::None } };
+        auto journaledConfig = bookConfig;
+        journaledConfig.journal_ = &journal;
+        Orderbook orderbook{ journaledConfig };
+        for (std::size_t index = 0; index < commands.size(); ++index){
+            orderbook.ExpireOrders(ExpiryWheel::ToTimestamp(FuzzEpochTick + index * FuzzTicksPerCommand));
+            orderbook.ProcessCommand(commands[index]);
+        }
+        journal.Flush();
+        live = orderbook.GetOrderInfos();
+        liveSize = orderbook.Size();
+    }
+
+    std::ostringstream reason;
+    {
+        const JournalReader journal{ path };
+        bookConfig.journal_ = nullptr;
+        Orderbook replayed{ bookConfig };
+        const auto applied = replayed.Replay(journal);
+        const auto infos = replayed.GetOrderInfos();
+        if (applied != journal.Records().size())
+            reason << "replay stopped after " << applied << " of " << journal.Records().size() << " records";
+        else if (infos.GetBids() != live.GetBids())
+            reason << "replayed bid levels differ";
+        else if (infos.GetAsks() != live.GetAsks())
+            reason << "replayed ask levels differ";
+        else if (replayed.Size() != liveSize)
+            reason << replayed.Size() << " replayed orders, expected " << liveSize;
+    }
+    std::filesystem::remove(path);
+
+    DifferentialResult result;
+    if (reason.tellp() == 0)
+        result.agreed_ = commands.size();
+    else{
+        result.failure_ = commands.size();
+        result.reason_ = reason.str();
+    }
+    return result;
+}
+
+/**
+ * @brief A check of a command stream against a book configuration, such as RunDifferential or RunJournalRoundTrip.
+ */
+using StreamCheck = DifferentialResult (*)(std::span<const Command>, OrderbookConfig);
+
+/**
+ * @brief Drops commands from a diverging stream for as long as the books still diverge.
+ *
+ * Starts from the shortest failing prefix and removes ever smaller runs of commands, keeping each
+ * removal after which the books still disagree and cutting back to the new failing prefix, so the
+ * result is usually a handful of commands rather than thousands.
+ * @param commands A stream on which the books diverge.
+ * @param bookConfig Settings of the optimised book.
+ * @param check The check that fails on the stream.
+ * @return A failing stream no run of which can be dropped at the final granularity; empty if the books agree.
+ */
+inline Commands ShrinkDivergence(std::span<const Command> commands, const OrderbookConfig& bookConfig = { }, StreamCheck check = RunDifferential){
+    const auto first = check(commands, bookConfig);
+    if (first)
+        return { };
+
+    Commands failing{ commands.begin(), commands.begin() + static_cast<std::ptrdiff_t>(*first.failure_) };
+    for (auto run = failing.size() / 2; run > 0; run /= 2){
+        for (std::size_t start = 0; start < failing.size();){
+            Commands candidate{ failing.begin(), failing.begin() + static_cast<std::ptrdiff_t>(start) };
+            candidate.insert(candidate.end(), failing.begin() + static_cast<std::ptrdiff_t>(std::min(start + run, failing.size())), failing.end());
+
+            const auto result = check(candidate, bookConfig);
+            if (result)
+                start += run;
+            else{
+                candidate.resize(*result.failure_);
+                failing = std::move(candidate);
+            }
+        }
+    }
+    return failing;
+}
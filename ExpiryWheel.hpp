@@ -0,0 +1,243 @@
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+
+#include "Using.hpp"
+#include "OrderPool.hpp"
+
+/**
+ * @class ExpiryWheel
+ * @brief Hierarchical timer wheel of order expiries, linked through the pool records.
+ *
+ * Ticks are milliseconds since the epoch. Level L has 64 slots of 64^L ticks each; an
+ * order is filed at the level of the highest 6-bit group in which its expiry differs
+ * from the current tick, so every order on level L shares all higher groups with the
+ * current tick. Advancing therefore only visits the slots the clock has reached, and
+ * an order is touched at most once per level on its way down. Expiries beyond the
+ * top level wait in an overflow list. Scheduling and cancelling are O(1); advancing
+ * costs O(levels + orders due or cascading).
+ */
+class ExpiryWheel{
+public:
+    /**
+     * @param pool Pool holding the records the wheel links together.
+     * @param now Tick the wheel starts at.
+     */
+    ExpiryWheel(OrderPool& pool, std::uint64_t now)
+        : pool_{ pool }
+        , current_{ now }
+    {
+        for (auto& level : slots_)
+            for (auto& slot : level)
+                slot = InvalidOrderHandle;
+    }
+
+    /**
+     * @brief Converts an instant to a wheel tick.
+     */
+    static std::uint64_t ToTick(Timestamp timestamp){
+        const auto ticks = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+        return ticks < 0 ? 0 : static_cast<std::uint64_t>(ticks);
+    }
+
+    /**
+     * @brief Converts a wheel tick back to an instant.
+     */
+    static Timestamp ToTimestamp(std::uint64_t tick){
+        return Timestamp{ std::chrono::duration_cast<Timestamp::duration>(std::chrono::milliseconds{ tick }) };
+    }
+
+    /**
+     * @brief The tick the wheel has advanced to.
+     */
+    std::uint64_t Current() const { return current_; }
+
+    /**
+     * @brief Moves the clock of an empty wheel, backwards if need be.
+     * @param now Tick the wheel continues from.
+     * @throws std::logic_error if orders are scheduled.
+     */
+    void Rewind(std::uint64_t now){
+        if (size_ != 0)
+            throw std::logic_error("Only an empty expiry wheel can be rewound.");
+        current_ = now;
+    }
+
+    /**
+     * @brief Number of orders scheduled.
+     */
+    std::size_t Size() const { return size_; }
+
+    /**
+     * @brief Registers an order to expire at a tick. The order must not be scheduled already.
+     * @param handle Record of the order.
+     * @param tick Expiry tick; must be later than Current().
+     */
+    void Schedule(OrderHandle handle, std::uint64_t tick){
+        pool_.Get(handle).expiryTick_ = tick;
+        Place(handle);
+        ++size_;
+    }
+
+    /**
+     * @brief Deregisters an order if it is scheduled; a no-op otherwise.
+     * @param handle Record of the order.
+     */
+    void Cancel(OrderHandle handle){
+        if (pool_.Queued(handle).expirySlot_ == 0)
+            return;
+        Unlink(handle);
+        --size_;
+    }
+
+    /**
+     * @brief Advances the wheel and hands every order whose expiry is at or before now to expire.
+     * @param now Tick to advance to; ticks before Current() are ignored.
+     * @param expire Called as expire(handle) for each due order, already deregistered.
+     */
+    template <typename Expire>
+    void Advance(std::uint64_t now, Expire&& expire){
+        if (now <= current_)
+            return;
+
+        // Detach every slot the clock has reached onto one pending list
+        OrderHandle pending = InvalidOrderHandle;
+        for (std::size_t level = 0; level < Levels; ++level){
+            const auto shift = level * SlotBits;
+            std::uint64_t due = occupied_[level];
+
+            if ((current_ >> (shift + SlotBits)) == (now >> (shift + SlotBits))){
+                const auto nowSlot = (now >> shift) & SlotMask;
+                due &= nowSlot == SlotMask ? ~std::uint64_t{ 0 } : (std::uint64_t{ 2 } << nowSlot) - 1;
+            }
+
+            while (due){
+                const auto slot = static_cast<std::size_t>(std::countr_zero(due));
+                due &= due - 1;
+                Splice(slots_[level][slot], pending);
+                occupied_[level] &= ~(std::uint64_t{ 1 } << slot);
+            }
+        }
+
+        if ((current_ >> (Levels * SlotBits)) != (now >> (Levels * SlotBits)))
+            Splice(overflow_, pending);
+
+        current_ = now;
+
+        // Expire what is due; cascade the rest to the lower level it now belongs to
+        while (pending != InvalidOrderHandle){
+            const auto handle = pending;
+            auto& record = pool_.Get(handle);
+            pending = record.expiryNext_;
+
+            pool_.Queued(handle).expirySlot_ = 0;
+            if (record.expiryTick_ <= now){
+                --size_;
+                expire(handle);
+            }else
+                Place(handle);
+        }
+    }
+
+    /**
+     * @brief Earliest tick at which an order can be due, or nothing if none is scheduled.
+     *
+     * Exact for orders on the lowest level, a lower bound otherwise; advancing to it
+     * cascades the next orders down.
+     */
+    std::optional<std::uint64_t> NextDeadline() const{
+        for (std::size_t level = 0; level < Levels; ++level){
+            if (occupied_[level] == 0)
+                continue;
+
+            const auto shift = level * SlotBits;
+            const auto slot = static_cast<std::uint64_t>(std::countr_zero(occupied_[level]));
+            const auto block = (current_ >> (shift + SlotBits)) << (shift + SlotBits);
+            return block | (slot << shift);
+        }
+
+        if (overflow_ != InvalidOrderHandle)
+            return ((current_ >> (Levels * SlotBits)) + 1) << (Levels * SlotBits);
+
+        return std::nullopt;
+    }
+
+private:
+    static constexpr std::size_t Levels = 6;
+    static constexpr std::size_t SlotBits = 6;
+    static constexpr std::size_t SlotCount = std::size_t{ 1 } << SlotBits;
+    static constexpr std::uint64_t SlotMask = SlotCount - 1;
+    static constexpr std::uint16_t OverflowSlot = Levels * SlotCount + 1;
+
+    // File a record under the level of the highest 6-bit group where its tick differs from now.
+    void Place(OrderHandle handle){
+        const auto& record = pool_.Get(handle);
+        auto& expirySlot = pool_.Queued(handle).expirySlot_;
+        const auto level = static_cast<std::size_t>(std::bit_width(record.expiryTick_ ^ current_) - 1) / SlotBits;
+
+        if (level >= Levels){
+            expirySlot = OverflowSlot;
+            PushFront(overflow_, handle);
+            return;
+        }
+
+        const auto slot = (record.expiryTick_ >> (level * SlotBits)) & SlotMask;
+        expirySlot = static_cast<std::uint16_t>(level * SlotCount + slot + 1);
+        PushFront(slots_[level][slot], handle);
+        occupied_[level] |= std::uint64_t{ 1 } << slot;
+    }
+
+    OrderHandle& HeadOf(std::uint16_t expirySlot){
+        if (expirySlot == OverflowSlot)
+            return overflow_;
+        return slots_[(expirySlot - 1) / SlotCount][(expirySlot - 1) % SlotCount];
+    }
+
+    void PushFront(OrderHandle& head, OrderHandle handle){
+        auto& record = pool_.Get(handle);
+        record.expiryPrev_ = InvalidOrderHandle;
+        record.expiryNext_ = head;
+        if (head != InvalidOrderHandle)
+            pool_.Get(head).expiryPrev_ = handle;
+        head = handle;
+    }
+
+    void Unlink(OrderHandle handle){
+        auto& record = pool_.Get(handle);
+        auto& expirySlot = pool_.Queued(handle).expirySlot_;
+        auto& head = HeadOf(expirySlot);
+
+        if (record.expiryPrev_ == InvalidOrderHandle)
+            head = record.expiryNext_;
+        else
+            pool_.Get(record.expiryPrev_).expiryNext_ = record.expiryNext_;
+        if (record.expiryNext_ != InvalidOrderHandle)
+            pool_.Get(record.expiryNext_).expiryPrev_ = record.expiryPrev_;
+
+        if (head == InvalidOrderHandle && expirySlot != OverflowSlot){
+            const auto index = expirySlot - 1;
+            occupied_[index / SlotCount] &= ~(std::uint64_t{ 1 } << (index % SlotCount));
+        }
+        expirySlot = 0;
+    }
+
+    // Move a whole slot list onto the front of another list.
+    void Splice(OrderHandle& from, OrderHandle& to){
+        while (from != InvalidOrderHandle){
+            const auto handle = from;
+            from = pool_.Get(handle).expiryNext_;
+            PushFront(to, handle);
+        }
+    }
+
+    OrderPool& pool_;
+    std::uint64_t current_;
+    OrderHandle slots_[Levels][SlotCount];
+    std::uint64_t occupied_[Levels]{ };
+    OrderHandle overflow_{ InvalidOrderHandle };
+    std::size_t size_{ };
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Size of the pages an arena maps its memory in.
+ */
+inline constexpr std::size_t HugePageSize = std::size_t{ 2 } << 20;
+
+/**
+ * @brief NUMA node a CPU core belongs to.
+ * @param core Zero-based core number.
+ * @return The node, or -1 if the core is negative or its node is unknown.
+ */
+inline int NodeOfCore(int core){
+    if (core < 0)
+        return -1;
+
+    #if defined(__linux__)
+    // sysfs lists a core's node as a nodeN entry of its cpu directory
+    std::error_code error;
+    const std::filesystem::path cpu{ "/sys/devices/system/cpu/cpu" + std::to_string(core) };
+    for (const auto& entry : std::filesystem::directory_iterator{ cpu, error }){
+        const auto name = entry.path().filename().string();
+        int node;
+        if (name.starts_with("node") && std::from_chars(name.data() + 4, name.data() + name.size(), node).ec == std::errc{ })
+            return node;
+    }
+    #endif
+    return -1;
+}
+
+/**
+ * @class HugePageArena
+ * @brief Grow-only memory for a book's and a pipeline's long-lived arrays, in 2 MB pages on one NUMA node.
+ *
+ * Memory is mapped in 2 MB-aligned regions and handed out by bumping an offset; nothing is
+ * returned before the arena is destroyed. Each region is first asked for as explicit huge pages
+ * (MAP_HUGETLB), then as ordinary pages advised for transparent huge pages, so the arena works
+ * on hosts with no huge pages reserved. Regions are bound to the node with a preferred policy,
+ * which falls back to other nodes when the node is full.
+ *
+ * Not thread-safe: the owning book allocates under its lock, or on its single writer thread.
+ */
+class HugePageArena{
+public:
+    /**
+     * @param node NUMA node to place the memory on; a negative value keeps the default policy.
+     */
+    explicit HugePageArena(int node = -1) : node_{ node } { }
+
+    HugePageArena(const HugePageArena&) = delete;
+    void operator=(const HugePageArena&) = delete;
+    HugePageArena(HugePageArena&&) = delete;
+    void operator=(HugePageArena&&) = delete;
+
+    ~HugePageArena(){
+        for (const auto& region : regions_)
+            Unmap(region);
+    }
+
+    /**
+     * @brief Carves a block out of the current region, mapping a new one if it does not fit.
+     * @param bytes Size of the block.
+     * @param alignment Power-of-two alignment of the block.
+     * @return The block; valid until the arena is destroyed.
+     * @throws std::bad_alloc if no memory could be mapped.
+     */
+    void* Allocate(std::size_t bytes, std::size_t alignment){
+        auto offset = (used_ + alignment - 1) & ~(alignment - 1);
+        if (regions_.empty() || offset + bytes > regions_.back().size_){
+            Map((bytes + HugePageSize - 1) / HugePageSize * HugePageSize);
+            offset = 0;
+        }
+
+        used_ = offset + bytes;
+        return regions_.back().base_ + offset;
+    }
+
+    /**
+     * @brief Node the arena places its memory on, or -1.
+     */
+    int Node() const { return node_; }
+
+    /**
+     * @brief Bytes mapped so far.
+     */
+    std::size_t Reserved() const{
+        std::size_t bytes{ };
+        for (const auto& region : regions_)
+            bytes += region.size_;
+        return bytes;
+    }
+
+    /**
+     * @brief Bytes of Reserved() backed by explicit huge pages rather than transparent ones or regular pages.
+     */
+    std::size_t HugeTlbReserved() const{
+        std::size_t bytes{ };
+        for (const auto& region : regions_)
+            bytes += region.hugeTlb_ ? region.size_ : 0;
+        return bytes;
+    }
+
+private:
+    struct Region{
+        std::byte* base_;
+        std::size_t size_;
+        bool hugeTlb_;
+    };
+
+    void Map(std::size_t size){
+        size = std::max(size, HugePageSize);
+
+        #if defined(__linux__)
+        constexpr int Protection = PROT_READ | PROT_WRITE;
+        constexpr int Flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+        if (auto* base = mmap(nullptr, size, Protection, Flags | MAP_HUGETLB, -1, 0); base != MAP_FAILED){
+            Bind(base, size);
+            regions_.push_back(Region{ static_cast<std::byte*>(base), size, true });
+            return;
+        }
+
+        // No huge pages reserved: over-map and keep a 2 MB-aligned span for transparent huge pages
+        auto* raw = mmap(nullptr, size + HugePageSize, Protection, Flags, -1, 0);
+        if (raw == MAP_FAILED)
+            throw std::bad_alloc{ };
+
+        auto* begin = static_cast<std::byte*>(raw);
+        auto* base = reinterpret_cast<std::byte*>((reinterpret_cast<std::uintptr_t>(begin) + HugePageSize - 1) & ~(HugePageSize - 1));
+        if (base != begin)
+            munmap(begin, static_cast<std::size_t>(base - begin));
+        if (const auto tail = static_cast<std::size_t>(begin + size + HugePageSize - (base + size)); tail != 0)
+            munmap(base + size, tail);
+
+        madvise(base, size, MADV_HUGEPAGE);
+        Bind(base, size);
+        regions_.push_back(Region{ base, size, false });
+        #else
+        regions_.push_back(Region{ static_cast<std::byte*>(::operator new(size, std::align_val_t{ HugePageSize })), size, false });
+        #endif
+    }
+
+    // Prefer the arena's node for the region's pages; they are placed as they are first touched
+    void Bind([[maybe_unused]] void* base, [[maybe_unused]] std::size_t size) const{
+        #if defined(__linux__) && defined(SYS_mbind)
+        constexpr int PreferredPolicy = 1;   // MPOL_PREFERRED
+        if (node_ < 0 || node_ >= static_cast<int>(sizeof(unsigned long) * 8))
+            return;
+        const unsigned long nodes = 1ul << node_;
+        syscall(SYS_mbind, base, size, PreferredPolicy, &nodes, sizeof(nodes) * 8, 0);
+        #endif
+    }
+
+    static void Unmap(const Region& region){
+        #if defined(__linux__)
+        munmap(region.base_, region.size_);
+        #else
+        ::operator delete(region.base_, std::align_val_t{ HugePageSize });
+        #endif
+    }
+
+    int node_;
+    std::vector<Region> regions_;
+    std::size_t used_{ };
+};
+
+/**
+ * @class ArenaAllocator
+ * @brief Standard allocator drawing from a HugePageArena, or from the heap when it has none.
+ *
+ * Deallocation is a no-op for arena memory, so it suits containers sized once or grown only,
+ * such as a ladder's slots, a pool's chunks and a ring's cells.
+ *
+ * @tparam T Element type.
+ */
+template <typename T>
+class ArenaAllocator{
+public:
+    using value_type = T;
+
+    ArenaAllocator(HugePageArena* arena = nullptr) noexcept : arena_{ arena } { }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_{ other.arena_ } { }
+
+    T* allocate(std::size_t count){
+        if (!arena_)
+            return std::allocator<T>{ }.allocate(count);
+        return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t count) noexcept{
+        if (!arena_)
+            std::allocator<T>{ }.deallocate(pointer, count);
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.arena_; }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    HugePageArena* arena_;
+};
+
+/**
+ * @brief Vector whose elements live in a HugePageArena when given one.
+ */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
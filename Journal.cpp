@@ -0,0 +1,247 @@
+#include "Journal.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ThreadAffinity.hpp"
+
+namespace{
+    /**
+     * @struct JournalHeader
+     * @brief First block of a journal file; as large as a record so records stay aligned in a mapping.
+     */
+    struct JournalHeader{
+        char magic_[8]{ 'O', 'B', 'J', 'O', 'U', 'R', 'N', 'L' };
+        std::uint32_t version_{ 3 };
+        std::uint32_t recordSize_{ sizeof(JournalRecord) };
+        std::uint8_t reserved_[24]{ };
+    };
+
+    static_assert(sizeof(JournalHeader) == sizeof(JournalRecord));
+
+    // CRC-32C (Castagnoli), reflected, one table lookup per byte
+    constexpr auto Crc32cTable = []{
+        std::array<std::uint32_t, 256> table{ };
+        for (std::uint32_t byte = 0; byte < table.size(); ++byte){
+            auto crc = byte;
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ (crc & 1 ? 0x82F63B78u : 0);
+            table[byte] = crc;
+        }
+        return table;
+    }();
+
+    std::uint32_t Crc32c(const OrderMessage& message){
+        std::uint8_t bytes[sizeof(OrderMessage)];
+        std::memcpy(bytes, &message, sizeof(bytes));
+
+        std::uint32_t crc = ~0u;
+        for (const auto byte : bytes)
+            crc = (crc >> 8) ^ Crc32cTable[(crc ^ byte) & 0xFF];
+        return ~crc;
+    }
+
+    [[noreturn]] void ThrowSystemError(const char* what){
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    void CheckHeader(const JournalHeader& header){
+        const JournalHeader expected;
+        if (std::memcmp(header.magic_, expected.magic_, sizeof(expected.magic_)) != 0 ||
+            header.version_ != expected.version_ || header.recordSize_ != expected.recordSize_)
+            throw std::runtime_error("File is not a journal of this version.");
+    }
+}
+
+JournalRecord JournalRecord::Seal(const OrderMessage& message){
+    JournalRecord record;
+    static_cast<OrderMessage&>(record) = message;
+    record.checksum_ = Crc32c(message);
+    return record;
+}
+
+bool JournalRecord::Intact() const{
+    return checksum_ == Crc32c(*this);
+}
+
+JournalWriter::JournalWriter(const std::filesystem::path& path, const JournalConfig& config)
+    : config_{ config }
+    , records_{ config.capacity_ }
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+        ThrowSystemError("Cannot open journal");
+
+    try{
+        struct stat status;
+        if (::fstat(fd_, &status) != 0)
+            ThrowSystemError("Cannot stat journal");
+
+        if (status.st_size == 0){
+            const JournalHeader header;
+            if (::write(fd_, &header, sizeof(header)) != sizeof(header))
+                ThrowSystemError("Cannot write journal header");
+        }else{
+            JournalHeader header;
+            if (::pread(fd_, &header, sizeof(header), 0) != sizeof(header))
+                throw std::runtime_error("File is not a journal of this version.");
+            CheckHeader(header);
+
+            // Drop a record torn by a crash mid-write
+            const auto whole = static_cast<off_t>(status.st_size / sizeof(JournalRecord) * sizeof(JournalRecord));
+            if (whole != status.st_size && ::ftruncate(fd_, whole) != 0)
+                ThrowSystemError("Cannot truncate journal");
+            base_ = static_cast<std::uint64_t>(whole) / sizeof(JournalRecord) - 1;
+        }
+
+        if (::lseek(fd_, 0, SEEK_END) < 0)
+            ThrowSystemError("Cannot seek journal");
+    }catch (...){
+        ::close(fd_);
+        throw;
+    }
+
+    thread_ = std::thread{ [this] {
+        PinCurrentThread(config_.core_);
+        Run();
+    } };
+}
+
+JournalWriter::~JournalWriter(){
+    running_.store(false, std::memory_order_release);
+    thread_.join();
+    ::close(fd_);
+}
+
+void JournalWriter::Flush(){
+    const auto target = records_.Claimed();
+    while (written_.load(std::memory_order_acquire) < target)
+        std::this_thread::yield();
+    Sync();
+}
+
+// Drain the ring in batches: one write per batch, then sync as the policy says
+void JournalWriter::Run(){
+    using namespace std::chrono;
+
+    std::vector<JournalRecord> batch;
+    batch.reserve(config_.batchRecords_);
+    auto lastSync = steady_clock::now();
+    bool unsynced = false;
+    SpinBackoff backoff;
+
+    while (true){
+        OrderMessage message;
+        while (batch.size() < config_.batchRecords_ && records_.TryConsume(message))
+            batch.push_back(JournalRecord::Seal(message));
+
+        if (!batch.empty()){
+            Write(batch.data(), batch.size());
+            written_.fetch_add(batch.size(), std::memory_order_release);
+            batch.clear();
+            unsynced = true;
+            backoff.Reset();
+
+            if (config_.sync_ == JournalSync::EveryBatch){
+                Sync();
+                unsynced = false;
+            }
+        }else{
+            if (!running_.load(std::memory_order_acquire) && written_.load(std::memory_order_relaxed) == records_.Claimed())
+                break;
+            backoff.Pause();
+        }
+
+        if (unsynced && config_.sync_ == JournalSync::Interval && steady_clock::now() - lastSync >= config_.syncInterval_){
+            Sync();
+            lastSync = steady_clock::now();
+            unsynced = false;
+        }
+    }
+
+    if (unsynced && config_.sync_ != JournalSync::None)
+        Sync();
+}
+
+void JournalWriter::Write(const JournalRecord* records, std::size_t count){
+    auto data = reinterpret_cast<const char*>(records);
+    auto remaining = count * sizeof(JournalRecord);
+
+    while (remaining > 0){
+        const auto written = ::write(fd_, data, remaining);
+        if (written < 0){
+            if (errno == EINTR)
+                continue;
+            ThrowSystemError("Cannot write journal");
+        }
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+}
+
+void JournalWriter::Sync(){
+    #if defined(__linux__)
+    const auto result = ::fdatasync(fd_);
+    #else
+    const auto result = ::fsync(fd_);
+    #endif
+    if (result != 0)
+        ThrowSystemError("Cannot sync journal");
+}
+
+JournalReader::JournalReader(const std::filesystem::path& path){
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        ThrowSystemError("Cannot open journal");
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0){
+        const auto error = errno;
+        ::close(fd);
+        errno = error;
+        ThrowSystemError("Cannot stat journal");
+    }
+
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ < sizeof(JournalHeader)){
+        ::close(fd);
+        throw std::runtime_error("File is not a journal of this version.");
+    }
+
+    mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    const auto error = errno;
+    ::close(fd);
+    if (mapping_ == MAP_FAILED){
+        mapping_ = nullptr;
+        errno = error;
+        ThrowSystemError("Cannot map journal");
+    }
+
+    try{
+        CheckHeader(*static_cast<const JournalHeader*>(mapping_));
+    }catch (...){
+        ::munmap(mapping_, size_);
+        throw;
+    }
+
+    // Replay reads front to back once: let the kernel read ahead aggressively
+    ::madvise(mapping_, size_, MADV_SEQUENTIAL);
+    ::madvise(mapping_, size_, MADV_WILLNEED);
+
+    const auto first = static_cast<const JournalRecord*>(mapping_) + 1;
+    records_ = std::span<const JournalRecord>{ first, size_ / sizeof(JournalRecord) - 1 };
+}
+
+JournalReader::~JournalReader(){
+    if (mapping_)
+        ::munmap(mapping_, size_);
+}
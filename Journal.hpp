@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <thread>
+#include <type_traits>
+
+#include "Using.hpp"
+#include "Protocol.hpp"
+#include "Ring.hpp"
+
+/**
+ * @struct JournalRecord
+ * @brief Journal entry: the protocol message of an accepted command, or an Expire message, with its checksum.
+ *
+ * Good-Till-Date and Good-For-Day orders carry the expiry tick they were given, so a
+ * replay schedules them exactly as the book did.
+ */
+struct JournalRecord : OrderMessage{
+    std::uint32_t checksum_{ };   ///< CRC-32C of the message.
+    std::uint32_t padding_{ };
+
+    /**
+     * @brief Record of a message, with the message's checksum.
+     * @param message The message.
+     */
+    static JournalRecord Seal(const OrderMessage& message);
+
+    /**
+     * @brief Checks the message against its checksum.
+     * @return True / false.
+     */
+    bool Intact() const;
+};
+
+static_assert(sizeof(JournalRecord) == 40 && std::is_trivially_copyable_v<JournalRecord>);
+
+/**
+ * @enum JournalSync
+ * @brief When the journal writer forces written records to stable storage.
+ */
+enum class JournalSync{
+    None,       ///< Never; the OS flushes on its own schedule.
+    EveryBatch, ///< After every batch written: group commit.
+    Interval,   ///< At most once per syncInterval_.
+};
+
+/**
+ * @struct JournalConfig
+ * @brief Buffering and durability settings of a JournalWriter.
+ */
+struct JournalConfig{
+    JournalSync sync_{ JournalSync::EveryBatch };
+    std::chrono::milliseconds syncInterval_{ 10 }; ///< Used by JournalSync::Interval.
+    std::size_t batchRecords_{ 4096 };             ///< Most records gathered into one write.
+    std::size_t capacity_{ 1 << 16 };              ///< Slots of the ring between the book and the writer thread.
+    int core_{ -1 };                               ///< Core to pin the writer thread to; negative leaves it unpinned.
+};
+
+/**
+ * @class JournalWriter
+ * @brief Append-only binary journal of accepted book commands.
+ *
+ * Books hand messages to a lock-free ring and return at once; a writer thread drains the
+ * ring in batches, seals each message with its checksum, writes the batch with one system
+ * call and syncs it according to the
+ * configured policy, so the matching thread never waits on the disk. A record that was
+ * only partly written when the process died is cut off when the file is reopened.
+ * Write failures are fatal.
+ */
+class JournalWriter{
+public:
+    /**
+     * @brief Opens or creates the journal and starts the writer thread.
+     * @param path Journal file; appended to if it exists.
+     * @param config Buffering and durability settings.
+     * @throws std::system_error if the file cannot be opened.
+     * @throws std::runtime_error if the file is not a journal.
+     */
+    explicit JournalWriter(const std::filesystem::path& path, const JournalConfig& config = { });
+
+    JournalWriter(const JournalWriter&) = delete;
+    void operator=(const JournalWriter&) = delete;
+    JournalWriter(JournalWriter&&) = delete;
+    void operator=(JournalWriter&&) = delete;
+
+    /**
+     * @brief Writes and syncs everything appended, then closes the file.
+     */
+    ~JournalWriter();
+
+    /**
+     * @brief Queues a message to be written as a record, waiting while the ring is full. Safe to call from any thread.
+     * @param message The message.
+     */
+    void Append(const OrderMessage& message) { records_.Publish(message); }
+
+    /**
+     * @brief Blocks until every record appended before the call is written and synced, whatever the policy.
+     */
+    void Flush();
+
+    /**
+     * @brief Number of records written to the file by this writer so far.
+     */
+    std::uint64_t Written() const { return written_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Index in the file that the next appended record will have, counting records of earlier sessions.
+     */
+    std::uint64_t Position() const { return base_ + records_.Claimed(); }
+
+private:
+    void Run();
+    void Write(const JournalRecord* records, std::size_t count);
+    void Sync();
+
+    JournalConfig config_;
+    int fd_{ -1 };
+    std::uint64_t base_{ };
+    MpscRing<OrderMessage> records_;
+    alignas(CacheLineSize) std::atomic<std::uint64_t> written_{ };
+    std::atomic<bool> running_{ true };
+    std::thread thread_;
+};
+
+/**
+ * @class JournalReader
+ * @brief Read-only mapping of a journal file, exposing its complete records in place.
+ *
+ * Records are not checked on opening; a reader calls JournalRecord::Intact on each.
+ */
+class JournalReader{
+public:
+    /**
+     * @param path Journal file.
+     * @throws std::system_error if the file cannot be opened or mapped.
+     * @throws std::runtime_error if the file is not a journal.
+     */
+    explicit JournalReader(const std::filesystem::path& path);
+
+    JournalReader(const JournalReader&) = delete;
+    void operator=(const JournalReader&) = delete;
+    JournalReader(JournalReader&&) = delete;
+    void operator=(JournalReader&&) = delete;
+    ~JournalReader();
+
+    /**
+     * @brief Every complete record, in the order written.
+     */
+    std::span<const JournalRecord> Records() const { return records_; }
+
+private:
+    void* mapping_{ };
+    std::size_t size_{ };
+    std::span<const JournalRecord> records_;
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Command.hpp"
+#include "OrderTypes.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Instrumentation is compiled in only when the build sets ORDERBOOK_LATENCY_STATS=1
+#if !defined(ORDERBOOK_LATENCY_STATS)
+#define ORDERBOOK_LATENCY_STATS 0
+#endif
+
+/**
+ * @brief Cheap timestamp for latency measurement: the TSC on x86, steady-clock nanoseconds elsewhere.
+ */
+inline std::uint64_t ReadCycles(){
+    #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    return __rdtsc();
+    #else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    #endif
+}
+
+/**
+ * @brief Rate of ReadCycles, measured against the steady clock on first use (a few milliseconds of spinning).
+ */
+inline double CyclesPerNanosecond(){
+    #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    static const double rate = []{
+        const auto start = std::chrono::steady_clock::now();
+        const auto startCycles = ReadCycles();
+        auto now = start;
+        while (now - start < std::chrono::milliseconds(5))
+            now = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::duration<double, std::nano>(now - start).count();
+        return static_cast<double>(ReadCycles() - startCycles) / elapsed;
+    }();
+    return rate;
+    #else
+    return 1.0;
+    #endif
+}
+
+/**
+ * @struct LatencySummary
+ * @brief Percentiles of one histogram, in nanoseconds.
+ */
+struct LatencySummary{
+    std::uint64_t count_{ };
+    std::uint64_t p50_{ };
+    std::uint64_t p99_{ };
+    std::uint64_t p999_{ };
+    std::uint64_t max_{ };
+};
+
+/**
+ * @class LatencyHistogram
+ * @brief Log-linear histogram of cycle counts, in the manner of HdrHistogram.
+ *
+ * Values below 16 have a bucket each; above that every power of two is split into 16
+ * buckets, so a reported percentile is within 1/16 of the recorded value. Recording is
+ * a relaxed atomic increment, so readers and concurrent writers never block.
+ */
+class LatencyHistogram{
+public:
+    static constexpr unsigned SubBucketBits = 4;
+    static constexpr std::size_t SubBuckets = std::size_t{ 1 } << SubBucketBits;
+    static constexpr std::size_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    /**
+     * @brief Records one measurement.
+     * @param cycles Duration in ReadCycles units.
+     */
+    void Record(std::uint64_t cycles){
+        buckets_[Index(cycles)].fetch_add(1, std::memory_order_relaxed);
+        auto max = max_.load(std::memory_order_relaxed);
+        while (cycles > max && !max_.compare_exchange_weak(max, cycles, std::memory_order_relaxed)) { }
+    }
+
+    /**
+     * @brief Count, percentiles and maximum of what was recorded since the last reset.
+     * @param cyclesPerNanosecond Conversion from recorded units; see CyclesPerNanosecond.
+     */
+    LatencySummary Summarize(double cyclesPerNanosecond) const{
+        std::array<std::uint64_t, BucketCount> counts;
+        LatencySummary summary;
+        for (std::size_t index = 0; index < BucketCount; ++index)
+            summary.count_ += counts[index] = buckets_[index].load(std::memory_order_relaxed);
+        if (summary.count_ == 0)
+            return summary;
+
+        const auto max = max_.load(std::memory_order_relaxed);
+        auto ToNanoseconds = [&](std::uint64_t cycles){
+            return static_cast<std::uint64_t>(static_cast<double>(cycles) / cyclesPerNanosecond + 0.5);
+        };
+        // Highest value of the bucket holding the given rank, capped at the maximum seen
+        auto Percentile = [&](double fraction){
+            const auto rank = std::max<std::uint64_t>(static_cast<std::uint64_t>(fraction * static_cast<double>(summary.count_) + 0.5), 1);
+            std::uint64_t seen{ };
+            for (std::size_t index = 0; index < BucketCount; ++index){
+                seen += counts[index];
+                if (seen >= rank)
+                    return ToNanoseconds(std::min(UpperBound(index), max));
+            }
+            return ToNanoseconds(max);
+        };
+
+        summary.p50_ = Percentile(0.5);
+        summary.p99_ = Percentile(0.99);
+        summary.p999_ = Percentile(0.999);
+        summary.max_ = ToNanoseconds(max);
+        return summary;
+    }
+
+    /**
+     * @brief Forgets every measurement. Ones recorded concurrently may or may not survive.
+     */
+    void Reset(){
+        for (auto& bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static std::size_t Index(std::uint64_t value){
+        if (value < SubBuckets)
+            return static_cast<std::size_t>(value);
+        const auto magnitude = static_cast<unsigned>(std::bit_width(value)) - 1;
+        const auto subBucket = (value >> (magnitude - SubBucketBits)) & (SubBuckets - 1);
+        return (magnitude - SubBucketBits + 1) * SubBuckets + static_cast<std::size_t>(subBucket);
+    }
+
+    static std::uint64_t UpperBound(std::size_t index){
+        if (index < SubBuckets)
+            return index;
+        const auto magnitude = static_cast<unsigned>(index / SubBuckets) + SubBucketBits - 1;
+        const auto lower = (SubBuckets + index % SubBuckets) << (magnitude - SubBucketBits);
+        return lower + (std::uint64_t{ 1 } << (magnitude - SubBucketBits)) - 1;
+    }
+
+    std::array<std::atomic<std::uint64_t>, BucketCount> buckets_{ };
+    std::atomic<std::uint64_t> max_{ };
+};
+
+/**
+ * @struct LatencyReport
+ * @brief Latency of the book's operations, as snapshot by BasicOrderbook::GetLatencyStats.
+ */
+struct LatencyReport{
+    LatencySummary add_;                    ///< Whole AddOrder call, matching included.
+    std::array<LatencySummary, OrderTypeCount> addByType_; ///< add_ split by OrderType, indexed by its value.
+    LatencySummary cancel_;
+    LatencySummary modify_;                 ///< Whole ModifyOrder call, matching included.
+    LatencySummary match_;                  ///< Each sweep of an incoming or repriced order, crossing or not.
+    LatencySummary lockWait_;               ///< Time the public API waited for the book lock.
+};
+
+/**
+ * @class LatencyStats
+ * @brief Per-operation latency histograms of a book; an empty shell unless ORDERBOOK_LATENCY_STATS is set.
+ *
+ * The book takes a Now() stamp where an operation starts and hands it back when it ends.
+ * With instrumentation off both are constant no-ops and no histogram is allocated, so the
+ * hot path is unchanged.
+ */
+class LatencyStats{
+public:
+    static constexpr bool Enabled = ORDERBOOK_LATENCY_STATS != 0;
+
+    static std::uint64_t Now(){
+        if constexpr (Enabled)
+            return ReadCycles();
+        else
+            return 0;
+    }
+
+    /**
+     * @brief Records an applied command by its type. Mass cancels are not recorded.
+     * @param command The command.
+     * @param start Now() when it started.
+     */
+    void RecordCommand(const Command& command, std::uint64_t start){
+        if constexpr (Enabled){
+            const auto cycles = ReadCycles() - start;
+            switch (command.type_){
+                case CommandType::Add:
+                    histograms_->add_.Record(cycles);
+                    histograms_->addByType_[static_cast<std::size_t>(command.orderType_) % OrderTypeCount].Record(cycles);
+                    break;
+                case CommandType::Modify: histograms_->modify_.Record(cycles); break;
+                case CommandType::Cancel: histograms_->cancel_.Record(cycles); break;
+                default: break;
+            }
+        }
+    }
+
+    void RecordMatch(std::uint64_t start){
+        if constexpr (Enabled)
+            histograms_->match_.Record(ReadCycles() - start);
+    }
+
+    void RecordLockWait(std::uint64_t start){
+        if constexpr (Enabled)
+            histograms_->lockWait_.Record(ReadCycles() - start);
+    }
+
+    /**
+     * @brief Percentiles of everything recorded since the last reset; all zero with instrumentation off.
+     */
+    LatencyReport Report() const{
+        LatencyReport report;
+        if constexpr (Enabled){
+            const auto rate = CyclesPerNanosecond();
+            report.add_ = histograms_->add_.Summarize(rate);
+            for (std::size_t type = 0; type < report.addByType_.size(); ++type)
+                report.addByType_[type] = histograms_->addByType_[type].Summarize(rate);
+            report.cancel_ = histograms_->cancel_.Summarize(rate);
+            report.modify_ = histograms_->modify_.Summarize(rate);
+            report.match_ = histograms_->match_.Summarize(rate);
+            report.lockWait_ = histograms_->lockWait_.Summarize(rate);
+        }
+        return report;
+    }
+
+    void Reset(){
+        if constexpr (Enabled){
+            histograms_->add_.Reset();
+            for (auto& histogram : histograms_->addByType_)
+                histogram.Reset();
+            histograms_->cancel_.Reset();
+            histograms_->modify_.Reset();
+            histograms_->match_.Reset();
+            histograms_->lockWait_.Reset();
+        }
+    }
+
+private:
+    struct Histograms{
+        LatencyHistogram add_;
+        std::array<LatencyHistogram, OrderTypeCount> addByType_;
+        LatencyHistogram cancel_;
+        LatencyHistogram modify_;
+        LatencyHistogram match_;
+        LatencyHistogram lockWait_;
+    };
+
+    // About 80 KiB when enabled, so kept off the book's own cache lines; never allocated otherwise
+    std::unique_ptr<Histograms> histograms_{ Enabled ? std::make_unique<Histograms>() : nullptr };
+};
@@ -5,6 +5,8 @@
 struct LevelInfo{
     Price price_;
     Quantity quantity_;
+
+    bool operator==(const LevelInfo&) const = default;
 };
 
 /**
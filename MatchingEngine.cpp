@@ -0,0 +1,167 @@
+#include "MatchingEngine.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace{
+    // Commands applied between expiry checks while a shard's ring stays busy
+    constexpr std::uint64_t ExpiryCheckInterval = 64;
+}
+
+MatchingEngine::MatchingEngine(const EngineConfig& config, EventHandler handler)
+    : config_{ config }
+    , handler_{ std::move(handler) }
+{
+    const auto shardCount = std::max<std::size_t>(config_.shardCount_, 1);
+    for (std::size_t shard = 0; shard < shardCount; ++shard){
+        const int core = shard < config_.shardCores_.size() ? config_.shardCores_[shard] : -1;
+        auto arena = config_.hugePages_ ? std::make_unique<HugePageArena>(NodeOfCore(core)) : nullptr;
+        shards_.push_back(std::make_unique<Shard>(config_.commandCapacity_, std::move(arena)));
+    }
+}
+
+MatchingEngine::~MatchingEngine(){
+    if (!running_.load(std::memory_order_acquire))
+        return;
+
+    running_.store(false, std::memory_order_release);
+    for (auto& shard : shards_)
+        shard->thread_.join();
+}
+
+void MatchingEngine::AddInstrument(InstrumentId instrumentId, const OrderbookConfig& config){
+    if (running_.load(std::memory_order_acquire))
+        throw std::logic_error("Instruments must be added before the engine starts.");
+
+    auto& shard = *shards_[ShardOf(instrumentId)];
+    auto bookConfig = config;
+    bookConfig.startPruneThread_ = false;
+    if (shard.arena_)
+        bookConfig.arena_ = shard.arena_.get();
+
+    auto& books = shard.books_;
+    if (books.contains(instrumentId))
+        throw std::logic_error("Instrument already registered.");
+    books.emplace(instrumentId, ShardBook{ std::make_unique<Orderbook>(bookConfig) });
+}
+
+void MatchingEngine::Start(){
+    if (running_.exchange(true, std::memory_order_acq_rel))
+        return;
+
+    for (std::size_t index = 0; index < shards_.size(); ++index){
+        const int core = index < config_.shardCores_.size() ? config_.shardCores_[index] : -1;
+        auto& shard = *shards_[index];
+        shard.thread_ = std::thread{ [this, &shard, core] { RunShard(shard, core); } };
+    }
+}
+
+std::uint64_t MatchingEngine::Submit(InstrumentId instrumentId, const Command& command){
+    return shards_[ShardOf(instrumentId)]->commands_.Publish(EngineCommand{ instrumentId, command });
+}
+
+void MatchingEngine::Flush() const{
+    for (const auto& shard : shards_){
+        const auto target = shard->commands_.Claimed();
+        while (shard->processed_.load(std::memory_order_acquire) < target)
+            std::this_thread::yield();
+    }
+}
+
+const Orderbook* MatchingEngine::GetOrderbook(InstrumentId instrumentId) const{
+    const auto& books = shards_[ShardOf(instrumentId)]->books_;
+    const auto book = books.find(instrumentId);
+    return book == books.end() ? nullptr : book->second.book_.get();
+}
+
+// Single writer of every book in the shard
+void MatchingEngine::RunShard(Shard& shard, int core){
+    PinCurrentThread(core);
+
+    EngineCommand command;
+    SpinBackoff backoff{ config_.idle_ };
+    std::uint64_t lastTick{ };
+
+    while (true){
+        if (!shard.commands_.TryConsume(command)){
+            if (!running_.load(std::memory_order_acquire) && shard.processed_.load(std::memory_order_relaxed) == shard.commands_.Claimed())
+                return;
+            ExpireOrders(shard, lastTick);
+            backoff.Pause();
+            continue;
+        }
+        backoff.Reset();
+
+        const auto sequence = shard.processed_.load(std::memory_order_relaxed);
+        if (sequence % ExpiryCheckInterval == 0)
+            ExpireOrders(shard, lastTick);
+
+        // Each book collects its trades into its own reused buffer
+        const auto book = shard.books_.find(command.instrumentId_);
+        if (book == shard.books_.end()){
+            Publish(command, sequence, CommandStatus::UnknownInstrument, { });
+            shard.processed_.store(sequence + 1, std::memory_order_release);
+            continue;
+        }
+
+        auto& trades = book->second.book_->GetListener().GetTrades();
+        trades.clear();
+        const auto status = book->second.book_->ProcessCommandInternal(command.command_);
+        // Only an add or a modify can rest an order, and so bring the book's next expiry forward
+        if (command.command_.type_ == CommandType::Add || command.command_.type_ == CommandType::Modify)
+            ScheduleExpiry(shard, book->second);
+        Publish(command, sequence, status, trades);
+        shard.processed_.store(sequence + 1, std::memory_order_release);
+    }
+}
+
+void MatchingEngine::Publish(const EngineCommand& command, std::uint64_t sequence, CommandStatus status, const Trades& trades){
+    if (!handler_)
+        return;
+
+    PipelineEvent event;
+    event.sequence_ = sequence;
+    event.command_ = command.command_.type_;
+    event.status_ = status;
+    event.orderId_ = command.command_.orderId_;
+    event.type_ = status == CommandStatus::Accepted ? PipelineEventType::Accepted : PipelineEventType::Rejected;
+    handler_(command.instrumentId_, event);
+
+    event.type_ = PipelineEventType::Trade;
+    for (const auto& trade : trades){
+        event.bidTrade_ = trade.GetBidTrade();
+        event.askTrade_ = trade.GetAskTrade();
+        handler_(command.instrumentId_, event);
+    }
+}
+
+// Advance the expiry wheels of the books whose deadline has passed, at most once per clock tick
+void MatchingEngine::ExpireOrders(Shard& shard, std::uint64_t& lastTick){
+    const auto now = ExpiryWheel::ToTick(std::chrono::system_clock::now());
+    if (now == lastTick)
+        return;
+
+    lastTick = now;
+    auto& deadlines = shard.deadlines_;
+    while (!deadlines.empty() && deadlines.top().first <= now){
+        const auto [deadline, entry] = deadlines.top();
+        deadlines.pop();
+        if (deadline != entry->deadline_)
+            continue;
+
+        entry->deadline_ = NoDeadline;
+        entry->book_->ExpireOrdersInternal(now);
+        ScheduleExpiry(shard, *entry);
+    }
+}
+
+// File a book under its wheel's next deadline if that is earlier than the one it is filed under.
+// A deadline that moved later, as cancels leave it, keeps the earlier entry, which then finds nothing due.
+void MatchingEngine::ScheduleExpiry(Shard& shard, ShardBook& entry){
+    const auto deadline = entry.book_->expiries_.NextDeadline();
+    if (!deadline || *deadline >= entry.deadline_)
+        return;
+
+    entry.deadline_ = *deadline;
+    shard.deadlines_.emplace(*deadline, &entry);
+}
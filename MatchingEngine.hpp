@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Orderbook.hpp"
+#include "OrderbookPipeline.hpp"
+#include "Command.hpp"
+#include "Ring.hpp"
+#include "HugePageArena.hpp"
+#include "ThreadAffinity.hpp"
+
+/**
+ * @struct EngineConfig
+ * @brief Sharding, ring sizing and thread and memory placement of a MatchingEngine.
+ */
+struct EngineConfig{
+    std::size_t shardCount_{ 1 };             ///< Number of matching threads; each owns a disjoint set of books.
+    std::vector<int> shardCores_{ };          ///< Core to pin each shard to, by shard index; missing entries stay unpinned.
+    std::size_t commandCapacity_{ 1 << 16 };  ///< Slots of each shard's input ring.
+    IdleStrategy idle_{ IdleStrategy::Backoff }; ///< How shard threads wait for commands.
+    bool hugePages_{ false };                 ///< Take each shard's ring and its books' pools and ladders from 2 MB pages on the shard core's NUMA node.
+};
+
+/**
+ * @class MatchingEngine
+ * @brief Owns many order books keyed by instrument and spreads them over a fixed set of shard threads.
+ *
+ * Instrument i belongs to shard i % shardCount_. Each shard has its own command ring and is the
+ * single writer of its books, so independent instruments never contend with each other. Shards
+ * also expire Good-For-Day and Good-Till-Date orders in their books between commands, so no book
+ * runs its own prune thread: each shard keeps its books in a min-heap by the next deadline of
+ * their expiry wheels, and a clock tick only visits the books whose deadline has passed.
+ */
+class MatchingEngine{
+public:
+    /**
+     * @brief Called on the shard thread for every event of every instrument the shard owns.
+     */
+    using EventHandler = std::function<void(InstrumentId, const PipelineEvent&)>;
+
+    /**
+     * @param config Sharding and ring sizing.
+     * @param handler Receives command results and trades; may be empty.
+     */
+    MatchingEngine(const EngineConfig& config, EventHandler handler = { });
+
+    MatchingEngine(const MatchingEngine&) = delete;
+    void operator=(const MatchingEngine&) = delete;
+    MatchingEngine(MatchingEngine&&) = delete;
+    void operator=(MatchingEngine&&) = delete;
+
+    /**
+     * @brief Processes everything already submitted, then stops all threads.
+     */
+    ~MatchingEngine();
+
+    /**
+     * @brief Registers a book for an instrument. Only allowed before Start().
+     * @param instrumentId Id of the instrument.
+     * @param config Settings of the instrument's book.
+     * @throws std::logic_error if the engine is running or the instrument already exists.
+     */
+    void AddInstrument(InstrumentId instrumentId, const OrderbookConfig& config);
+
+    /**
+     * @brief Starts the shard threads.
+     */
+    void Start();
+
+    /**
+     * @brief Routes a command to the shard owning the instrument, waiting while its ring is full.
+     * @param instrumentId Instrument the command is for.
+     * @param command The command.
+     * @return Sequence of the command within its shard, as carried by its events.
+     */
+    std::uint64_t Submit(InstrumentId instrumentId, const Command& command);
+
+    /**
+     * @brief Blocks until every command submitted before the call has been applied.
+     */
+    void Flush() const;
+
+    /**
+     * @brief The book of an instrument. Only safe to inspect after Flush() with no producers running.
+     * @return The book, or nullptr if the instrument is unknown.
+     */
+    const Orderbook* GetOrderbook(InstrumentId instrumentId) const;
+
+    /**
+     * @brief Index of the shard that owns an instrument.
+     */
+    std::size_t ShardOf(InstrumentId instrumentId) const { return instrumentId % shards_.size(); }
+
+private:
+    struct EngineCommand{
+        InstrumentId instrumentId_{ };
+        Command command_{ };
+    };
+
+    /**
+     * @brief A book and the deadline it is filed under in its shard's heap.
+     */
+    struct ShardBook{
+        std::unique_ptr<Orderbook> book_;
+        std::uint64_t deadline_{ NoDeadline };   ///< The live heap entry of the book; entries with another deadline are stale.
+    };
+
+    static constexpr std::uint64_t NoDeadline = ~std::uint64_t{ 0 };
+
+    using Deadline = std::pair<std::uint64_t, ShardBook*>;
+
+    struct Shard{
+        Shard(std::size_t capacity, std::unique_ptr<HugePageArena> arena)
+            : arena_{ std::move(arena) }
+            , commands_{ capacity, arena_.get() }
+        { }
+
+        std::unique_ptr<HugePageArena> arena_;   ///< Null unless the engine uses huge pages.
+        MpscRing<EngineCommand> commands_;
+        std::unordered_map<InstrumentId, ShardBook> books_;
+        std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> deadlines_;   ///< Books by next expiry, earliest first.
+        alignas(CacheLineSize) std::atomic<std::uint64_t> processed_{ };
+        std::thread thread_;
+    };
+
+    void RunShard(Shard& shard, int core);
+    void ExpireOrders(Shard& shard, std::uint64_t& lastTick);
+    static void ScheduleExpiry(Shard& shard, ShardBook& entry);
+    void Publish(const EngineCommand& command, std::uint64_t sequence, CommandStatus status, const Trades& trades);
+
+    EngineConfig config_;
+    EventHandler handler_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> running_{ false };
+};
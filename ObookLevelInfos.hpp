@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "LevelInfo.hpp"
 
 
@@ -15,10 +17,12 @@ public:
      * 
      * @param bids The bid levels in the order book.
      * @param asks The ask levels in the order book.
+     * @param sequence Depth sequence the levels reflect.
      */
-    OrderbookLevelInfos(const LevelInfos& bids, const LevelInfos& asks)
+    OrderbookLevelInfos(const LevelInfos& bids, const LevelInfos& asks, std::uint64_t sequence = 0)
         : bids_{ bids }
         , asks_{ asks }
+        , sequence_{ sequence }
     { }
     /**
      * @brief Gets the bid levels of the order book.
@@ -34,7 +38,13 @@ public:
      */
     const LevelInfos& GetAsks() const { return asks_; }
 
+    /**
+     * @brief Depth sequence the levels reflect, to resume from with GetDepthChanges.
+     */
+    std::uint64_t GetSequence() const { return sequence_; }
+
 private:
     LevelInfos bids_;
     LevelInfos asks_;
+    std::uint64_t sequence_;
 };
\ No newline at end of file
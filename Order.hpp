@@ -1,5 +1,7 @@
 #pragma once
+#include <algorithm>
 #include <list>
+#include <memory>
 #include <exception>
 #include <sstream>
 
@@ -24,7 +26,19 @@ class Order{
      * @param price The price at which the order is placed.
      * @param quantity The initial quantity of the order.
      */
-        Order(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity): orderType_ {orderType}, orderId_ {orderId}, side_ {side}, price_ {price}, initialQuantity_ {quantity}, remainingQuantity_ {quantity} {};
+        Order(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity): Order (orderType, orderId, side, price, quantity, Timestamp{}) {}
+
+    /**
+     * @brief Order with an expiry, used for GoodTillDate orders.
+     * 
+     * @param orderType The type of the order (e.g., GoodTillDate).
+     * @param orderId The unique identifier for the order.
+     * @param side The side of the order (e.g., Buy or Sell).
+     * @param price The price at which the order is placed.
+     * @param quantity The initial quantity of the order.
+     * @param expiry Instant at which the order is cancelled if still resting.
+     */
+        Order(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity, Timestamp expiry): orderType_ {orderType}, orderId_ {orderId}, side_ {side}, price_ {price}, initialQuantity_ {quantity}, remainingQuantity_ {quantity}, expiry_ {expiry} {};
 
     /**
      * @brief Constructs a market order with the specified parameters.
@@ -37,6 +51,17 @@ class Order{
      */
         Order(OrderId orderId, Side side, Quantity quantity): Order (OrderType::Market, orderId, side, Constants::InvalidPrice, quantity){}
 
+    /**
+     * @brief Constructs an iceberg order with the specified parameters.
+     * 
+     * @param orderId The unique identifier for the order.
+     * @param side The side of the order (e.g., Buy or Sell).
+     * @param price The price at which the order is placed.
+     * @param quantity The total quantity of the order.
+     * @param displayQuantity Largest quantity the order shows on its level at once.
+     */
+        Order(OrderId orderId, Side side, Price price, Quantity quantity, Quantity displayQuantity): Order (OrderType::Iceberg, orderId, side, price, quantity) { displayQuantity_ = displayQuantity; }
+
     /**
      * @brief Id of the order.
      * 
@@ -65,6 +90,27 @@ class Order{
      */
         OrderType GetOrderType() const {return orderType_;}
 
+    /**
+     * @brief Expiry of a GoodTillDate order.
+     * 
+     * @return The expiry instant; the epoch for orders without one.
+     */
+        Timestamp GetExpiry() const {return expiry_;}
+
+    /**
+     * @brief Size of the slices an Iceberg order shows.
+     * 
+     * @return The display quantity; zero for other order types.
+     */
+        Quantity GetDisplayQuantity() const {return displayQuantity_;}
+
+    /**
+     * @brief Quantity the order shows when it joins the back of a queue.
+     * 
+     * @return A full slice of what remains of an Iceberg order; all of what remains of any other.
+     */
+        Quantity GetSliceQuantity() const {return GetOrderType() == OrderType::Iceberg ? std::min(displayQuantity_, remainingQuantity_) : remainingQuantity_;}
+
     /**
      * @brief Initial quantity of the order when created.
      * 
@@ -125,13 +171,32 @@ class Order{
             price_ = price;
             orderType_ = OrderType::GoodTillCancel;
         }
+
+    /**
+     * @brief Replaces the side, price and quantity of the order in place, as a modify does.
+     * 
+     * The new quantity becomes both the initial and remaining quantity, so the order
+     * looks the same as one freshly added with these details.
+     * 
+     * @param side The new side.
+     * @param price The new price.
+     * @param quantity The new quantity.
+     */
+        void Amend(Side side, Price price, Quantity quantity) {
+            side_ = side;
+            price_ = price;
+            initialQuantity_ = quantity;
+            remainingQuantity_ = quantity;
+        }
     private:
         OrderType orderType_;
+        Quantity displayQuantity_{ };
         OrderId orderId_;
         Side side_;
         Price price_;
         Quantity initialQuantity_;
         Quantity remainingQuantity_;
+        Timestamp expiry_;
 };
  
 using OrderPointer = std::shared_ptr<Order>;
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "Using.hpp"
+#include "OrderPool.hpp"
+
+/**
+ * @struct OrderIdIndexStats
+ * @brief Occupancy and probing figures of an OrderIdIndex, for capacity planning.
+ */
+struct OrderIdIndexStats{
+    std::size_t size_{ };               ///< Ids held in total.
+    std::size_t denseSize_{ };          ///< Ids held in the direct-indexed window.
+    std::size_t denseCapacity_{ };      ///< Slots of the direct-indexed window.
+    std::size_t hashSize_{ };           ///< Ids held in the hash table.
+    std::size_t hashCapacity_{ };       ///< Slots of the hash table.
+    double loadFactor_{ };              ///< hashSize_ / hashCapacity_.
+    double averageProbeLength_{ };      ///< Mean distance of hashed ids from their home slot.
+    std::size_t maxProbeLength_{ };     ///< Largest distance of a hashed id from its home slot.
+};
+
+/**
+ * @class OrderIdIndex
+ * @brief Maps order ids to pool handles without per-entry allocation.
+ *
+ * Ids that arrive roughly in increasing order land in a direct-indexed window: a
+ * power-of-two ring covering [base, base + capacity) that slides forward as the
+ * oldest ids leave. An old id still resting at the front is moved to the hash table,
+ * unless the window is more than half full, in which case the window doubles. Any id
+ * the window cannot take goes to a linear-probing hash table whose deletes shift the
+ * following run back, so it never accumulates tombstones.
+ */
+class OrderIdIndex{
+public:
+    /**
+     * @brief Sizes the hash table for the given number of ids.
+     * @param capacity Number of ids expected to be live at once.
+     */
+    void Reserve(std::size_t capacity){
+        if (capacity * MaxLoadDenominator > slots_.size() * MaxLoadNumerator)
+            Rehash(std::bit_ceil(capacity * MaxLoadDenominator / MaxLoadNumerator + 1));
+    }
+
+    /**
+     * @brief Number of ids held.
+     */
+    std::size_t Size() const { return denseSize_ + hashSize_; }
+
+    /**
+     * @brief Finds the handle stored for an id.
+     * @param orderId Id to look up.
+     * @return The handle, or InvalidOrderHandle if the id is absent.
+     */
+    OrderHandle Find(OrderId orderId) const{
+        if (InWindow(orderId))
+            if (const auto handle = dense_[orderId & denseMask_]; handle != InvalidOrderHandle)
+                return handle;
+
+        if (hashSize_ == 0)
+            return InvalidOrderHandle;
+
+        for (auto index = Home(orderId);; index = (index + 1) & hashMask_){
+            const auto& slot = slots_[index];
+            if (slot.handle_ == InvalidOrderHandle)
+                return InvalidOrderHandle;
+            if (slot.orderId_ == orderId)
+                return slot.handle_;
+        }
+    }
+
+    /**
+     * @brief Checks if an id is held.
+     * @param orderId Id to look up.
+     * @return True / false.
+     */
+    bool Contains(OrderId orderId) const { return Find(orderId) != InvalidOrderHandle; }
+
+    /**
+     * @brief Stores the handle of a new id. The id must not be held already.
+     * @param orderId Id to store.
+     * @param handle Pool handle of the order.
+     */
+    void Insert(OrderId orderId, OrderHandle handle){
+        if (!DenseInsert(orderId, handle))
+            HashInsert(orderId, handle);
+    }
+
+    /**
+     * @brief Removes an id in a single probe sequence.
+     * @param orderId Id to remove.
+     * @return The handle that was stored, or InvalidOrderHandle if the id is absent.
+     */
+    OrderHandle Erase(OrderId orderId){
+        if (InWindow(orderId)){
+            auto& slot = dense_[orderId & denseMask_];
+            if (const auto handle = slot; handle != InvalidOrderHandle){
+                slot = InvalidOrderHandle;
+                --denseSize_;
+                return handle;
+            }
+        }
+
+        if (hashSize_ == 0)
+            return InvalidOrderHandle;
+
+        auto index = Home(orderId);
+        for (;; index = (index + 1) & hashMask_){
+            if (slots_[index].handle_ == InvalidOrderHandle)
+                return InvalidOrderHandle;
+            if (slots_[index].orderId_ == orderId)
+                break;
+        }
+
+        const auto handle = slots_[index].handle_;
+
+        // Backward shift: pull later members of the run into the hole unless they would move before their home
+        for (auto next = (index + 1) & hashMask_; slots_[next].handle_ != InvalidOrderHandle; next = (next + 1) & hashMask_){
+            const auto home = Home(slots_[next].orderId_);
+            const bool staysPut = index <= next ? (index < home && home <= next) : (index < home || home <= next);
+            if (staysPut)
+                continue;
+
+            slots_[index] = slots_[next];
+            index = next;
+        }
+
+        slots_[index].handle_ = InvalidOrderHandle;
+        --hashSize_;
+        return handle;
+    }
+
+    /**
+     * @brief Visits every (id, handle) pair, window first then hash table.
+     * @param visit Called as visit(orderId, handle).
+     */
+    template <typename Visitor>
+    void ForEach(Visitor&& visit) const{
+        for (std::size_t offset = 0; offset < dense_.size(); ++offset){
+            const auto orderId = denseBase_ + offset;
+            if (const auto handle = dense_[orderId & denseMask_]; handle != InvalidOrderHandle)
+                visit(static_cast<OrderId>(orderId), handle);
+        }
+
+        for (const auto& slot : slots_)
+            if (slot.handle_ != InvalidOrderHandle)
+                visit(slot.orderId_, slot.handle_);
+    }
+
+    /**
+     * @brief Computes occupancy and probe-length figures. Walks the hash table, O(capacity).
+     */
+    OrderIdIndexStats GetStats() const{
+        OrderIdIndexStats stats;
+        stats.size_ = Size();
+        stats.denseSize_ = denseSize_;
+        stats.denseCapacity_ = dense_.size();
+        stats.hashSize_ = hashSize_;
+        stats.hashCapacity_ = slots_.size();
+        stats.loadFactor_ = slots_.empty() ? 0.0 : static_cast<double>(hashSize_) / slots_.size();
+
+        std::size_t totalProbe{ };
+        for (std::size_t index = 0; index < slots_.size(); ++index){
+            if (slots_[index].handle_ == InvalidOrderHandle)
+                continue;
+            const auto probe = (index - Home(slots_[index].orderId_)) & hashMask_;
+            totalProbe += probe;
+            stats.maxProbeLength_ = std::max(stats.maxProbeLength_, probe);
+        }
+        stats.averageProbeLength_ = hashSize_ == 0 ? 0.0 : static_cast<double>(totalProbe) / hashSize_;
+        return stats;
+    }
+
+private:
+    struct Slot{
+        OrderId orderId_{ };
+        OrderHandle handle_{ InvalidOrderHandle };
+    };
+
+    static constexpr std::size_t MinHashCapacity = 64;
+    static constexpr std::size_t MaxLoadNumerator = 3;
+    static constexpr std::size_t MaxLoadDenominator = 4;
+    static constexpr std::size_t InitialDenseCapacity = std::size_t{ 1 } << 12;
+    static constexpr std::size_t MaxDenseCapacity = std::size_t{ 1 } << 26;
+
+    bool InWindow(OrderId orderId) const { return orderId - denseBase_ < dense_.size(); }
+
+    std::size_t Home(OrderId orderId) const { return (orderId * 0x9E3779B97F4A7C15ull) >> hashShift_; }
+
+    // Place an id in the window, sliding the window forward when the id is just past its end.
+    bool DenseInsert(OrderId orderId, OrderHandle handle){
+        if (dense_.empty()){
+            dense_.assign(InitialDenseCapacity, InvalidOrderHandle);
+            denseMask_ = InitialDenseCapacity - 1;
+            denseBase_ = orderId;
+        }
+        else if (denseSize_ == 0 && !InWindow(orderId))
+            denseBase_ = orderId;
+
+        // Ids behind the window or far beyond it are not part of a monotonic run
+        if (orderId < denseBase_ || orderId - denseBase_ >= 2 * dense_.size())
+            return false;
+
+        while (!InWindow(orderId)){
+            auto& front = dense_[denseBase_ & denseMask_];
+            if (front != InvalidOrderHandle){
+                if (denseSize_ * 2 > dense_.size() && dense_.size() < MaxDenseCapacity){
+                    GrowDense();
+                    continue;
+                }
+                HashInsert(denseBase_, front);
+                front = InvalidOrderHandle;
+                --denseSize_;
+            }
+            ++denseBase_;
+        }
+
+        dense_[orderId & denseMask_] = handle;
+        ++denseSize_;
+        return true;
+    }
+
+    void GrowDense(){
+        std::vector<OrderHandle> grown(dense_.size() * 2, InvalidOrderHandle);
+        const auto mask = grown.size() - 1;
+        for (std::size_t offset = 0; offset < dense_.size(); ++offset){
+            const auto orderId = denseBase_ + offset;
+            grown[orderId & mask] = dense_[orderId & denseMask_];
+        }
+        dense_.swap(grown);
+        denseMask_ = mask;
+    }
+
+    void HashInsert(OrderId orderId, OrderHandle handle){
+        if ((hashSize_ + 1) * MaxLoadDenominator > slots_.size() * MaxLoadNumerator)
+            Rehash(std::max<std::size_t>(slots_.size() * 2, MinHashCapacity));
+
+        auto index = Home(orderId);
+        while (slots_[index].handle_ != InvalidOrderHandle)
+            index = (index + 1) & hashMask_;
+
+        slots_[index] = Slot{ orderId, handle };
+        ++hashSize_;
+    }
+
+    void Rehash(std::size_t capacity){
+        std::vector<Slot> previous(capacity);
+        previous.swap(slots_);
+        hashMask_ = capacity - 1;
+        hashShift_ = 64 - std::countr_zero(capacity);
+        hashSize_ = 0;
+
+        for (const auto& slot : previous){
+            if (slot.handle_ == InvalidOrderHandle)
+                continue;
+            auto index = Home(slot.orderId_);
+            while (slots_[index].handle_ != InvalidOrderHandle)
+                index = (index + 1) & hashMask_;
+            slots_[index] = slot;
+            ++hashSize_;
+        }
+    }
+
+    std::vector<OrderHandle> dense_;
+    std::size_t denseMask_{ };
+    OrderId denseBase_{ };
+    std::size_t denseSize_{ };
+
+    std::vector<Slot> slots_;
+    std::size_t hashMask_{ };
+    int hashShift_{ 64 };
+    std::size_t hashSize_{ };
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "Order.hpp"
+#include "HugePageArena.hpp"
+
+/**
+ * @typedef OrderHandle
+ * @brief Index of an order record inside an OrderPool.
+ */
+using OrderHandle = std::uint32_t;
+
+/**
+ * @brief Handle value used to terminate intrusive lists and mark empty links.
+ */
+inline constexpr OrderHandle InvalidOrderHandle = std::numeric_limits<OrderHandle>::max();
+
+/**
+ * @struct QueuedOrder
+ * @brief Hot part of a pooled order: the fields matching reads while walking a level queue.
+ *
+ * Kept in an array of their own, 24 bytes each, so a sweep through a level reads one small
+ * node per order instead of the full order record. A level is still an intrusive list over
+ * slots that are reused last-freed first, so its entries are not adjacent in memory.
+ *
+ * For an Iceberg order, remaining_ holds what is left of the slice it shows rather than its
+ * whole remaining quantity; the full record knows the rest.
+ */
+struct QueuedOrder{
+    OrderId orderId_{ };
+    Quantity remaining_{ };        ///< Mirror of the order's remaining (Iceberg: shown) quantity while it is queued.
+    OrderHandle prev_{ InvalidOrderHandle }; ///< Previous order at the same price level.
+    OrderHandle next_{ InvalidOrderHandle }; ///< Next order at the same price level (or next free slot).
+    std::uint16_t expirySlot_{ };  ///< Wheel slot the order is scheduled in, 0 when not scheduled.
+    bool iceberg_{ };              ///< Hidden quantity may stand behind remaining_, to show once it runs out.
+};
+static_assert(sizeof(QueuedOrder) == 24, "QueuedOrder is packed to keep queue walks to one small node per order");
+
+/**
+ * @struct PooledOrder
+ * @brief Cold part of a pooled order: the full order and its expiry wheel links.
+ */
+struct PooledOrder{
+    Order order_{ OrderType::GoodTillCancel, 0, Side::Buy, Constants::InvalidPrice, 0 };
+    OrderHandle expiryPrev_{ InvalidOrderHandle }; ///< Previous order in the same expiry wheel slot.
+    OrderHandle expiryNext_{ InvalidOrderHandle }; ///< Next order in the same expiry wheel slot.
+    std::uint64_t expiryTick_{ };  ///< Expiry in wheel ticks; meaningful while the queued expirySlot_ is set.
+};
+
+/**
+ * @struct OrderList
+ * @brief Intrusive FIFO of pooled orders resting at one price level.
+ */
+struct OrderList{
+    OrderHandle head_{ InvalidOrderHandle };
+    OrderHandle tail_{ InvalidOrderHandle };
+
+    /**
+     * @brief Checks if no order rests in the list.
+     * @return True / false.
+     */
+    bool Empty() const { return head_ == InvalidOrderHandle; }
+};
+
+/**
+ * @class OrderPool
+ * @brief Slab allocator for order records addressed by stable handles.
+ *
+ * Records live in fixed-size chunks that are never moved or returned, so a handle stays valid
+ * until the record is released. Released records go on a free list and are reused first, which
+ * means a book whose live order count has plateaued performs no further allocation.
+ *
+ * Each chunk holds the hot QueuedOrder parts and the cold PooledOrder parts of its records in
+ * two separate arrays. A queued order's id and remaining quantity are mirrored in its hot part
+ * when it is pushed onto a level and by SyncQueued; matching updates the mirror and writes the
+ * order itself back only when it stays on the book. An Iceberg order's hot part shows a fresh
+ * slice of its remaining quantity each time it is pushed.
+ */
+class OrderPool{
+public:
+    /**
+     * @param arena Arena to take chunks from; the heap if null.
+     */
+    explicit OrderPool(HugePageArena* arena = nullptr) : allocator_{ arena } { }
+
+    OrderPool(const OrderPool&) = delete;
+    void operator=(const OrderPool&) = delete;
+
+    ~OrderPool(){
+        for (auto* chunk : chunks_){
+            std::destroy_at(chunk);
+            allocator_.deallocate(chunk, 1);
+        }
+    }
+
+    /**
+     * @brief Stores a copy of the order in a free record.
+     * @param order Order to store.
+     * @return Handle of the record, unlinked from any list.
+     */
+    OrderHandle Acquire(const Order& order){
+        if (free_ == InvalidOrderHandle)
+            Grow();
+
+        const auto handle = free_;
+        auto& queued = Queued(handle);
+        free_ = queued.next_;
+
+        Get(handle).order_ = order;
+        queued.prev_ = InvalidOrderHandle;
+        queued.next_ = InvalidOrderHandle;
+        queued.expirySlot_ = 0;
+        ++size_;
+        return handle;
+    }
+
+    /**
+     * @brief Returns a record to the free list. The record must not be linked in any list.
+     * @param handle Handle of the record to release.
+     */
+    void Release(OrderHandle handle){
+        auto& queued = Queued(handle);
+        queued.prev_ = InvalidOrderHandle;
+        queued.next_ = free_;
+        free_ = handle;
+        --size_;
+    }
+
+    /**
+     * @brief Pre-allocates enough chunks to hold the given number of records.
+     * @param capacity Number of records to make room for.
+     */
+    void Reserve(std::size_t capacity){
+        while (Capacity() < capacity)
+            Grow();
+    }
+
+    PooledOrder& Get(OrderHandle handle) { return chunks_[handle >> ChunkShift]->records_[handle & ChunkMask]; }
+    const PooledOrder& Get(OrderHandle handle) const { return chunks_[handle >> ChunkShift]->records_[handle & ChunkMask]; }
+
+    QueuedOrder& Queued(OrderHandle handle) { return chunks_[handle >> ChunkShift]->queued_[handle & ChunkMask]; }
+    const QueuedOrder& Queued(OrderHandle handle) const { return chunks_[handle >> ChunkShift]->queued_[handle & ChunkMask]; }
+
+    Order& operator[](OrderHandle handle) { return Get(handle).order_; }
+    const Order& operator[](OrderHandle handle) const { return Get(handle).order_; }
+
+    /**
+     * @brief Number of records currently handed out.
+     */
+    std::size_t Size() const { return size_; }
+
+    /**
+     * @brief Number of records allocated, live or free.
+     */
+    std::size_t Capacity() const { return chunks_.size() * ChunkSize; }
+
+    /**
+     * @brief Refreshes the hot mirror of a record after its order changed, showing a full slice of an Iceberg.
+     * @param handle Record to refresh.
+     */
+    void SyncQueued(OrderHandle handle){
+        const auto& order = Get(handle).order_;
+        auto& queued = Queued(handle);
+        queued.orderId_ = order.GetOrderId();
+        queued.remaining_ = order.GetSliceQuantity();
+        queued.iceberg_ = order.GetOrderType() == OrderType::Iceberg;
+    }
+
+    /**
+     * @brief Appends a record to the back of a level queue.
+     * @param list Queue to append to.
+     * @param handle Record to append.
+     */
+    void PushBack(OrderList& list, OrderHandle handle){
+        SyncQueued(handle);
+        auto& queued = Queued(handle);
+        queued.prev_ = list.tail_;
+        queued.next_ = InvalidOrderHandle;
+
+        if (list.tail_ == InvalidOrderHandle)
+            list.head_ = handle;
+        else
+            Queued(list.tail_).next_ = handle;
+        list.tail_ = handle;
+    }
+
+    /**
+     * @brief Unlinks a record from a level queue in O(1).
+     * @param list Queue the record is linked in.
+     * @param handle Record to unlink.
+     */
+    void Erase(OrderList& list, OrderHandle handle){
+        auto& queued = Queued(handle);
+
+        if (queued.prev_ == InvalidOrderHandle)
+            list.head_ = queued.next_;
+        else
+            Queued(queued.prev_).next_ = queued.next_;
+
+        if (queued.next_ == InvalidOrderHandle)
+            list.tail_ = queued.prev_;
+        else
+            Queued(queued.next_).prev_ = queued.prev_;
+
+        queued.prev_ = InvalidOrderHandle;
+        queued.next_ = InvalidOrderHandle;
+    }
+
+private:
+    static constexpr std::size_t ChunkShift = 12;
+    static constexpr std::size_t ChunkSize = std::size_t{ 1 } << ChunkShift;
+    static constexpr std::size_t ChunkMask = ChunkSize - 1;
+
+    struct Chunk{
+        std::array<QueuedOrder, ChunkSize> queued_;
+        std::array<PooledOrder, ChunkSize> records_;
+    };
+
+    // Thread a fresh chunk onto the free list, lowest handle first.
+    void Grow(){
+        const auto base = static_cast<OrderHandle>(Capacity());
+        chunks_.reserve(chunks_.size() + 1);
+        auto* chunk = chunks_.emplace_back(std::construct_at(allocator_.allocate(1)));
+
+        for (std::size_t i = ChunkSize; i-- > 0;){
+            chunk->queued_[i].next_ = free_;
+            free_ = base + static_cast<OrderHandle>(i);
+        }
+    }
+
+    std::vector<Chunk*> chunks_;
+    ArenaAllocator<Chunk> allocator_;
+    OrderHandle free_{ InvalidOrderHandle };
+    std::size_t size_{ };
+};
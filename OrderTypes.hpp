@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 /**
  * @enum OrderType
  * @brief Various types of orders that can be placed in the order book.
@@ -11,4 +13,11 @@ enum class OrderType
     FillOrKill,   ///< Fully fill immediately, or it is cancelled entirely.
     GoodForDay,  ///< Valid only for the trading day, then cancelled at EOD if not filled.
     Market,    ///< Order to buy or sell immediately at the best available price.
-};
\ No newline at end of file
+    GoodTillDate, ///< Order active until filled, cancelled or its expiry timestamp passes.
+    Iceberg,     ///< Good-Till-Cancel order showing only a slice of its quantity, refilled from the rest as it trades.
+};
+
+/**
+ * @brief Number of OrderType values, for tables indexed by type.
+ */
+inline constexpr std::size_t OrderTypeCount = 7;
\ No newline at end of file
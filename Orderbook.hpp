@@ -1,158 +1,1396 @@
 #pragma once
 
-#include <map>
-#include <unordered_map>
 #include <thread>
 #include <condition_variable>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include "Using.hpp"
 #include "Order.hpp"
+#include "OrderPool.hpp"
+#include "OrderIdIndex.hpp"
+#include "ExpiryWheel.hpp"
+#include "OrderbookConfig.hpp"
+#include "PriceLadder.hpp"
+#include "BookSide.hpp"
 #include "Change.hpp"
+#include "Command.hpp"
 #include "ObookLevelInfos.hpp"
+#include "DepthLog.hpp"
+#include "SessionClock.hpp"
+#include "BookListener.hpp"
+#include "Journal.hpp"
+#include "Snapshot.hpp"
 #include "Trade.hpp"
+#include "LatencyStats.hpp"
+#include "SeqLock.hpp"
+#include "BookSummary.hpp"
+#include "ThreadAffinity.hpp"
 
 /**
- * @class Orderbook
+ * @class BasicOrderbook
  * @brief Manages a collection of buy and sell orders, matching them to execute trades.
+ *
+ * Every add, cancel, trade and level change is reported inline to the listener the book
+ * owns, so a consumer streaming events downstream pays for no intermediate containers.
+ * Orderbook is the variant that collects trades and returns them per call.
+ *
+ * @tparam Listener Hook set, usually derived from BookListener.
  */
-class Orderbook{
+template <typename Listener>
+class BasicOrderbook{
 private:
 
+    OrderPool pool_;
+    PriceLadder<SideTraits<Side::Buy>::Compare> bids_;
+    PriceLadder<SideTraits<Side::Sell>::Compare> asks_;
+    OrderIdIndex orders_;
+    ExpiryWheel expiries_;
+    DepthLog depth_;
+    std::uint64_t sessionCloseTick_{ };
+    std::uint64_t pruneWakeTick_{ ~std::uint64_t{ 0 } };
+    std::vector<std::pair<Side, Price>> deferredLevels_;
+    bool deferLevels_{ };
+    Listener listener_;
+    JournalWriter* journal_;
+    mutable LatencyStats latency_;
+    std::uint64_t tradeCount_{ };
+    TradeInfo lastBidTrade_{ };
+    TradeInfo lastAskTrade_{ };
+    std::uint64_t summaryVersion_{ };
+    SeqLock<BookSummary> summary_;
+    mutable std::mutex ordersMutex_;
+    std::thread ordersPruneThread_;
+    std::condition_variable shutdownConditionVariable_;
+    std::atomic<bool> shutdown_{ false };
+
+    friend class Orderbook;
+    friend class OrderbookPipeline;
+    friend class MatchingEngine;
+
+     // Prune Good-For-Day and Good-Till-Date orders as their expiries come due.
+    void PruneExpiredOrders();
+
     /**
-     * @struct OrderEntry
-     * @brief Entry in the orders map, storing the order and its location in the bid/ask list.
+     * @brief Publishes the current top of book and totals to lock-free readers.
+     * Called by the writer after every change, with the lock held or as the single writer.
      */
-    struct OrderEntry{
-        OrderPointer order_{ nullptr };
-        OrderPointers::iterator location_;
-    };
+    void PublishSummary();
 
     /**
-     * @struct LevelData
-     * @brief Data at each price level, like the total quantity and order count.
+     * @brief Takes ordersMutex_, recording how long the caller waited for it.
+     * @return The held lock.
      */
-    struct LevelData{
-        Quantity quantity_{ };
-        Quantity count_{ };
+    std::unique_lock<std::mutex> LockOrders() const;
 
-        /**
-         * @enum Action
-         * @brief Actions that affect level data (adding, removing, or matching) orders.
-         */
-        enum class Action{
-            Add,
-            Remove,
-            Match,
-        };
-    };
-
-    std::unordered_map<Price, LevelData> data_;
-    std::map<Price, OrderPointers, std::greater<Price>> bids_;
-    std::map<Price, OrderPointers, std::less<Price>> asks_;
-    std::unordered_map<OrderId, OrderEntry> orders_;
-    mutable std::mutex ordersMutex_;
-    std::thread ordersPruneThread_;
-    std::condition_variable shutdownConditionVariable_;
-    std::atomic<bool> shutdown_{ false };
-
-     // Prune Good-for-Day orders that are no longer valid.
-    void PruneGoodForDayOrders();
+    /**
+     * @brief Cancels every resting order whose expiry is at or before the given tick.
+     * Caller must hold the lock or be the single writer.
+     * @param now Current time in ExpiryWheel ticks.
+     * @return Number of orders cancelled.
+     */
+    std::size_t ExpireOrdersInternal(std::uint64_t now);
 
     /**
-     * @brief Cancel multiple orders given their IDs.
-     * @param orderIds A list of IDs to be canceled.
+     * @brief Expiry tick of an order resting now, or zero if the order never expires.
+     * @param order The order being rested.
      */
-    void CancelOrders(OrderIds orderIds);
+    std::uint64_t ExpiryTickOf(const Order& order);
 
     /**
      * @brief Internal function to handle the cancellation of a single order.
      * @param orderId The ID of the order to be canceled.
+     * @return True if the order was resting and is now cancelled.
+     */
+    bool CancelOrderInternal(OrderId orderId);
+
+    /**
+     * @brief The ladder holding one side's levels.
+     * @tparam S Side of the ladder.
+     */
+    template <Side S>
+    auto& Levels(){
+        if constexpr (S == Side::Buy)
+            return bids_;
+        else
+            return asks_;
+    }
+
+    template <Side S>
+    const auto& Levels() const{
+        if constexpr (S == Side::Buy)
+            return bids_;
+        else
+            return asks_;
+    }
+
+    /**
+     * @brief Takes a resting order off its level, dropping the level if it empties.
+     * The order keeps its pool record, id entry and expiry.
+     * @tparam S Side the order rests on.
+     * @param handle The order.
+     */
+    template <Side S>
+    void UnlinkOrder(OrderHandle handle);
+
+    /**
+     * @brief Side-specialised body of AddOrderInternal, once the id has been checked.
+     * @tparam S Side of the order.
+     * @param incoming The order added.
+     * @return Whether the order was accepted, and why not.
+     */
+    template <Side S>
+    CommandStatus AddOrderInternal(const Order& incoming);
+
+    /**
+     * @brief Cancels every resting order of a side without locking.
+     * @param side Side to clear.
+     * @return Number of orders cancelled.
+     */
+    std::size_t CancelAllInternal(Side side);
+
+    /**
+     * @brief Internal function to add an order, without locking.
+     * @param order The order added.
+     * @return Whether the order was accepted, and why not.
      */
-    void CancelOrderInternal(OrderId orderId);
+    CommandStatus AddOrderInternal(const Order& order);
 
     /**
-     * @brief Called when an order is cancelled.
-     * @param order Pointer to the order that was cancelled.
+     * @brief Internal function to modify an order in place, without locking.
+     *
+     * A quantity cut at the same price and side keeps the order's queue position. Any other
+     * change moves the same pooled record to the back of its new level and, if the price or
+     * side changed, matches it. ValidateCommand has refused a quantity of zero.
+     * @param modify Order mod. details.
+     * @return Whether the modify was accepted, and why not.
      */
-    void OnOrderCancelled(OrderPointer order);
+    CommandStatus ModifyOrderInternal(const OrderModify& modify);
 
     /**
-     * @brief Called when a new order is added to the order book.
-     * @param order Pointer to the new added order.
+     * @brief Applies one command without locking, and journals it if accepted.
+     * Used by the public API and by single-writer drivers such as OrderbookPipeline.
+     * @param command The command to apply.
+     * @return Whether the command was accepted, and why not.
      */
-    void OnOrderAdded(OrderPointer order);
+    CommandStatus ProcessCommandInternal(const Command& command);
+
+    /**
+     * @brief Applies one command without locking or journaling.
+     * @param command The command to apply.
+     * @return Whether the command was accepted, and why not.
+     */
+    CommandStatus ApplyCommandInternal(const Command& command);
+
+    /**
+     * @brief Applies commands in order without locking, holding level reports back to the end.
+     * @param commands Commands to apply.
+     * @param applied Called as applied(status) after each command, before the next one starts.
+     */
+    template <typename Applied>
+    void ProcessBatchInternal(std::span<const Command> commands, Applied&& applied);
+
+    /**
+     * @brief Reports each level changed during a batch once, with its final aggregates.
+     */
+    void PublishDeferredLevels();
+
+    /**
+     * @brief Applies journal records without locking or journaling them again.
+     * @param records Records to apply, in order.
+     */
+    std::size_t ReplayInternal(std::span<const JournalRecord> records);
+
+    /**
+     * @brief Emits the snapshot records of the book. Runs in the forked snapshot process.
+     * @param writer Destination of the records.
+     * @param header Header of the snapshot, written first.
+     */
+    void WriteSnapshotInternal(SnapshotFileWriter& writer, const SnapshotHeader& header) const;
+
+    /**
+     * @brief Called when a new order, or what is left of it after matching, is queued in the order book.
+     * @param level Level the order was queued at.
+     * @param order The new added order.
+     */
+    void OnOrderAdded(PriceLevel& level, const Order& order);
 
     /**
      * @brief Order is matched and executed, providing details of the match.
-     * @param price Price at which the order was matched.
-     * @param quantity Quantity of the matched order.
-     * @param isFullyFilled If the order was fully filled.
+     * @param level Level the matched order rests at.
+     * @param side Side of the level.
+     * @param price Price of the level.
+     * @param quantity Quantity of the match.
+     * @param done Whether the matched order is used up and leaves the level.
      */
-    void OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled);
+    void OnOrderMatched(PriceLevel& level, Side side, Price price, Quantity quantity, bool done);
 
     /**
-     * @brief Updates level data for a specific price when an action occurs.
-     * @param price Price level affected.
+     * @brief Counts an order just queued at a level: its shown slice in the aggregates, the rest as hidden.
+     * @param level Level the order was queued at.
+     * @param order The order.
+     */
+    void AddToLevelData(PriceLevel& level, const Order& order);
+
+    /**
+     * @brief Changes a level's hidden Iceberg quantity, which the depth index counts but the aggregates do not.
+     * @param side Side of the level.
+     * @param price Price of the level.
+     * @param delta Signed change of the hidden quantity.
+     */
+    void AddHidden(Side side, Price price, std::int64_t delta);
+
+    /**
+     * @brief Shows the next slice of an Iceberg order whose slice traded away, at the back of its level.
+     *
+     * The queue entry is relinked in place: the record, its id entry and its expiry are untouched.
+     * @param level Level the order rests at.
+     * @param side Side of the level.
+     * @param price Price of the level.
+     * @param handle The order, with hidden quantity left.
+     */
+    void ReplenishOrder(PriceLevel& level, Side side, Price price, OrderHandle handle);
+
+    /**
+     * @brief Updates level data for a specific level when an action occurs, and reports the change.
+     * @param level Price level affected.
+     * @param order Order the action applies to; gives the level's side and price.
      * @param quantity Quantity associated with the action.
-     * @param action Action performed (add, remove, match).
+     * @param action Action performed (add, remove, match, reduce).
      */
-    void UpdateLevelData(Price price, Quantity quantity, LevelData::Action action);
+    void UpdateLevelData(PriceLevel& level, const Order& order, Quantity quantity, LevelData::Action action);
+
+    /**
+     * @brief Same as above for a level given by side and price.
+     */
+    void UpdateLevelData(PriceLevel& level, Side side, Price price, Quantity quantity, LevelData::Action action);
 
      /**
      * @brief Order can be fully filled at a given price and quantity.
-     * @param side Side of the order (buy/sell).
+     * @tparam S Side of the order (buy/sell).
      * @param price Price at which to check for fill capability.
      * @param quantity Quantity to be filled.
      * @return True / false.
      */
-    bool CanFullyFill(Side side, Price price, Quantity quantity) const;
+    template <Side S>
+    bool CanFullyFill(Price price, Quantity quantity) const;
+
+    /**
+     * @brief Applies a change of a level's quantity to its ladder's cumulative-depth index.
+     * @param side Side of the level.
+     * @param price Price of the level.
+     * @param delta Signed change of the level's quantity.
+     */
+    void AddDepth(Side side, Price price, std::int64_t delta);
 
     /**
      * @brief Order can match at the specified price.
-     * @param side Side of the order (buy/sell).
+     * @tparam S Side of the order (buy/sell).
      * @param price Price at which to check for match.
      * @return True / false.
      */
-    bool CanMatch(Side side, Price price) const;
-    Trades MatchOrders();
+    template <Side S>
+    bool CanMatch(Price price) const;
+
+    /**
+     * @brief Trades an incoming order against the opposite side, best level first, until it is
+     * filled or no longer crosses, reporting each trade to the listener.
+     *
+     * The order itself is not linked into any level while it sweeps: it is either a local copy
+     * of a new order or a modified record already taken off its old level.
+     * @tparam S Side of the incoming order.
+     * @param order The incoming order; filled in place.
+     */
+    template <Side S>
+    void MatchIncoming(Order& order);
+
+    /**
+     * @brief Matches a modified record at its new price and queues what is left of it.
+     * @tparam S New side of the order.
+     * @param handle The record, taken off its old level.
+     * @param repriced Whether the price or side changed, so the order may cross.
+     */
+    template <Side S>
+    void RequeueOrder(OrderHandle handle, bool repriced);
+
+    /**
+     * @brief Copies the aggregates of the best levels of each side, without locking.
+     * @param depth Maximum number of levels per side.
+     */
+    OrderbookLevelInfos CollectLevels(std::size_t depth) const;
 
 public:
 
-    Orderbook();
-    //Disable move and copy assignment opperator and constructors 
-    Orderbook(const Orderbook&) = delete;
-    void operator=(const Orderbook&) = delete;
-    Orderbook(Orderbook&&) = delete;
-    void operator=(Orderbook&&) = delete;
-    ~Orderbook();
+    BasicOrderbook();
 
-      /**
-     * @brief Adds order to the order book,  returns any resulting trades.
-     * @param order Pointer to the order added.
-     * @return Trades resulting from the new order.
+    /**
+     * @brief Creates a book whose price levels use the given ladder band.
+     * @param config Ladder band and pool sizing.
+     * @param listener Receives the book's events.
      */
-    Trades AddOrder(OrderPointer order);
+    explicit BasicOrderbook(const OrderbookConfig& config, Listener listener = { });
+    //Disable move and copy assignment opperator and constructors
+    BasicOrderbook(const BasicOrderbook&) = delete;
+    void operator=(const BasicOrderbook&) = delete;
+    BasicOrderbook(BasicOrderbook&&) = delete;
+    void operator=(BasicOrderbook&&) = delete;
+    ~BasicOrderbook();
+
+    /**
+     * @brief Adds order to the order book; trades and book changes go to the listener.
+     * @param order The order added. The book stores its own pooled copy.
+     * @return Whether the order was accepted, and why not.
+     */
+    CommandStatus AddOrder(const Order& order);
 
     /**
      * @brief Cancels an existing order given its  ID.
      * @param orderId The ID of the order canceling.
+     * @return Accepted, or UnknownOrderId if no such order rests.
      */
-    void CancelOrder(OrderId orderId);
+    CommandStatus CancelOrder(OrderId orderId);
 
     /**
-     * @brief Modify existing order and returns resulting trades.
+     * @brief Applies one command of any type; trades and book changes go to the listener.
+     * @param command The command.
+     * @return Whether the command was accepted, and why not.
+     */
+    CommandStatus ProcessCommand(const Command& command);
+
+    /**
+     * @brief Applies a sequence of commands under a single lock acquisition.
+     *
+     * The outcome is the same as passing each command to ProcessCommand in turn, and adds,
+     * cancels and trades reach the listener as they happen. Level changes are the exception:
+     * each level touched by the batch is reported once at the end, with its final aggregates.
+     * @param commands Commands to apply, in order.
+     * @param statuses Cleared, then receives the status of each command.
+     */
+    void ProcessBatch(std::span<const Command> commands, std::vector<CommandStatus>& statuses);
+
+    /**
+     * @brief Modify existing order; trades and book changes go to the listener.
+     *
+     * Reducing the quantity at the same price keeps the order's time priority; other changes
+     * send it to the back of the queue at its new price. The quantity of an Iceberg order is
+     * its total; a cut takes from its hidden reserve first.
      * @param order Order mod. details.
-     * @return Trades resulting from the modified order.
+     * @return Whether the modify was accepted, and why not.
      */
-    Trades ModifyOrder(OrderModify order);
+    CommandStatus ModifyOrder(const OrderModify& order);
+
     /**
-     * @brief Number of active orders in the order book.
+     * @brief Number of active orders in the order book, read without locking.
      * @return Total number of orders.
      */
     std::size_t Size() const;
+
+    /**
+     * @brief Top of book, level and order counts and the last trade, as of the latest applied command.
+     *
+     * Readers on any thread copy a consistent snapshot published by the writer through a
+     * seqlock; they never take the book's lock or block the writer.
+     * @return The summary.
+     */
+    BookSummary GetSummary() const;
+
+    /**
+     * @brief Quantity an order could trade right now, i.e. the opposite side's total at prices
+     * at least as good as its limit, hidden Iceberg quantity included.
+     *
+     * Read from a per-side cumulative-depth index in O(log levels), the same check
+     * Fill-Or-Kill admission uses.
+     * @param side Side of the would-be order.
+     * @param limitPrice Its limit price.
+     * @return Available quantity.
+     */
+    std::uint64_t AvailableLiquidity(Side side, Price limitPrice) const;
+
+    /**
+     * @brief Occupancy and probe-length figures of the order-id index.
+     * @return Index statistics.
+     */
+    OrderIdIndexStats GetOrderIndexStats() const;
+
+    /**
+     * @brief Cancels every resting Good-For-Day or Good-Till-Date order that has expired by the given time.
+     *
+     * The prune thread calls this on its own as deadlines come due; drivers that run
+     * without it call it from their matching loop.
+     * @param now Time to expire orders up to.
+     * @return Number of orders cancelled.
+     */
+    std::size_t ExpireOrders(Timestamp now);
+
+    /**
+     * @brief Every level of both sides with its total shown quantity, best first.
+     * Iceberg orders count only the slice they show; see AvailableLiquidity for what can trade.
+     * @return The levels, tagged with the depth sequence they reflect.
+     */
     OrderbookLevelInfos GetOrderInfos() const;
 
+    /**
+     * @brief The best levels of each side, best first. Costs O(depth), not O(levels).
+     * @param depth Maximum number of levels per side.
+     * @return The levels, tagged with the depth sequence they reflect.
+     */
+    OrderbookLevelInfos GetTopLevels(std::size_t depth) const;
+
+    /**
+     * @brief Best bid level, in O(1) and without locking.
+     * @return The level, or nothing if there are no bids.
+     */
+    std::optional<LevelInfo> GetBestBid() const;
+
+    /**
+     * @brief Best ask level, in O(1) and without locking.
+     * @return The level, or nothing if there are no asks.
+     */
+    std::optional<LevelInfo> GetBestAsk() const;
+
+    /**
+     * @brief Latest aggregates of every level changed after a depth sequence.
+     *
+     * Start from the sequence of a GetOrderInfos or GetTopLevels snapshot, then pass the
+     * returned sequence on the next call. Costs O(changes since the sequence).
+     * @param since Depth sequence the caller is up to date with.
+     * @param changes Cleared, then receives one entry per changed level; a count of zero removes the level.
+     * @return The sequence the changes bring the caller up to, or nothing if the change log no
+     * longer reaches back to since and a new snapshot is needed.
+     */
+    std::optional<std::uint64_t> GetDepthChanges(std::uint64_t since, LevelChanges& changes) const;
+
+    /**
+     * @brief Latency percentiles of the book's operations since the last reset.
+     *
+     * Only recorded when built with ORDERBOOK_LATENCY_STATS; all zero otherwise. Reads the
+     * histograms without taking the book's lock.
+     * @return Per-operation and per-order-type summaries, plus lock wait.
+     */
+    LatencyReport GetLatencyStats() const;
+
+    /**
+     * @brief Clears the latency histograms, e.g. after warming up.
+     */
+    void ResetLatencyStats();
+
+    /**
+     * @brief Re-applies a journal to a book that has not taken any order yet.
+     *
+     * Records are applied in place from the file mapping under a single lock, without being
+     * journaled again. Each is checked against its checksum and decoded as an inbound message
+     * would be; the replay stops at the first record that fails either. The expiry clock is
+     * held back while replaying so every recorded add is accepted again; orders whose expiry
+     * passed in the meantime go at the next expiry check.
+     * @param journal Journal to replay.
+     * @return Number of records applied.
+     * @throws std::logic_error if the book already holds orders.
+     */
+    std::size_t Replay(const JournalReader& journal);
+
+    /**
+     * @brief Starts writing a snapshot of the book in the background.
+     *
+     * The book is forked while locked and the child process writes the copy-on-write image
+     * of it, so matching only stops for the fork. The snapshot records how far the
+     * journal had got, for Restore to replay the rest.
+     * @param path Snapshot file; replaced once the new snapshot is complete.
+     * @return The running snapshot; Wait() tells whether it succeeded.
+     * @throws std::system_error if the process cannot fork.
+     */
+    SnapshotTask Snapshot(const std::filesystem::path& path) const;
+
+    /**
+     * @brief Rebuilds a book that has not taken any order yet from a snapshot, then replays the journal after it.
+     *
+     * Levels and queues are built directly from the mapped snapshot in priority order, in
+     * O(levels + orders) with no matching. Restored levels are reported as level changes.
+     * @param snapshot Snapshot to restore.
+     * @param journal Journal the snapshot's book wrote to, or nullptr to restore the snapshot alone.
+     * @return Number of journal records replayed after the snapshot; the replay stops as Replay's does.
+     * @throws std::logic_error if the book already holds orders.
+     * @throws std::runtime_error if the journal is shorter than the snapshot's position in it.
+     */
+    std::size_t Restore(const SnapshotReader& snapshot, const JournalReader* journal = nullptr);
+
+    /**
+     * @brief The listener receiving the book's events. Only touch it from the thread mutating the book.
+     */
+    Listener& GetListener() { return listener_; }
+    const Listener& GetListener() const { return listener_; }
+};
+
+// Instantiated once, in OrderBook.cpp
+extern template class BasicOrderbook<TradeCollector>;
+
+/**
+ * @struct BatchResults
+ * @brief Acks and trades of a batch, in one set of buffers reused from batch to batch.
+ */
+struct BatchResults{
+    std::vector<CommandStatus> statuses_;  ///< Status of each command.
+    std::vector<std::size_t> tradeEnds_;   ///< Trades of command i are trades_[tradeEnds_[i - 1], tradeEnds_[i]).
+    Trades trades_;                        ///< Trades of every command, in order.
+
+    /**
+     * @brief Trades resulting from one command of the batch.
+     * @param index Position of the command in the batch.
+     */
+    std::span<const Trade> TradesOf(std::size_t index) const{
+        const auto begin = index == 0 ? 0 : tradeEnds_[index - 1];
+        return std::span<const Trade>{ trades_ }.subspan(begin, tradeEnds_[index] - begin);
+    }
+};
+
+/**
+ * @class Orderbook
+ * @brief Order book that collects the trades of each call and returns them.
+ */
+class Orderbook : public BasicOrderbook<TradeCollector>{
+public:
+    using BasicOrderbook::BasicOrderbook;
+
+    /**
+     * @brief Adds order to the order book,  returns any resulting trades.
+     * @param order The order added. The book stores its own pooled copy.
+     * @return Trades resulting from the new order.
+     */
+    Trades AddOrder(const Order& order);
+
+    /**
+     * @brief Adapter for callers holding shared orders; forwards to AddOrder(const Order&).
+     * @param order Pointer to the order added. It is copied, not retained or filled in place.
+     * @return Trades resulting from the new order.
+     */
+    Trades AddOrder(OrderPointer order);
+
+    /**
+     * @brief Modify existing order and returns resulting trades.
+     * @param order Order mod. details.
+     * @return Trades resulting from the modified order.
+     */
+    Trades ModifyOrder(OrderModify order);
+
+    /**
+     * @brief Applies a sequence of commands under a single lock acquisition; see BasicOrderbook::ProcessBatch.
+     * @param commands Commands to apply, in order.
+     * @param results Cleared, then receives each command's status and trades.
+     */
+    void ProcessBatch(std::span<const Command> commands, BatchResults& results);
+};
+
+// Lock the book, timing the wait when instrumentation is compiled in
+template <typename Listener>
+std::unique_lock<std::mutex> BasicOrderbook<Listener>::LockOrders() const{
+    const auto start = LatencyStats::Now();
+    std::unique_lock ordersLock{ ordersMutex_ };
+    latency_.RecordLockWait(start);
+    return ordersLock;
+}
+
+// Cancel expired orders, then sleep until the wheel's next deadline
+template <typename Listener>
+void BasicOrderbook<Listener>::PruneExpiredOrders(){
+    std::unique_lock ordersLock{ ordersMutex_ };
+
+    while (!shutdown_.load(std::memory_order_acquire)){
+        ExpireOrdersInternal(ExpiryWheel::ToTick(std::chrono::system_clock::now()));
+
+        // AddOrderInternal lowers pruneWakeTick_ and notifies when it schedules an earlier deadline
+        const auto deadline = expiries_.NextDeadline();
+        pruneWakeTick_ = deadline.value_or(~std::uint64_t{ 0 });
+        if (deadline)
+            shutdownConditionVariable_.wait_until(ordersLock, ExpiryWheel::ToTimestamp(*deadline));
+        else
+            shutdownConditionVariable_.wait(ordersLock);
+    }
+}
+
+// Cancel every order the wheel hands back as due
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::ExpireOrdersInternal(std::uint64_t now){
+    std::size_t expired{ };
+    expiries_.Advance(now, [&](OrderHandle handle){
+        const auto orderId = pool_[handle].GetOrderId();
+        CancelOrderInternal(orderId);
+        if (journal_)
+            journal_->Append(OrderMessage::Expired(orderId));
+        ++expired;
+    });
+    if (expired != 0)
+        PublishSummary();
+    return expired;
+}
+
+// Good-Till-Date orders carry their own expiry; Good-For-Day orders expire at the session close, unless they carry the close they were given, as replayed ones do
+template <typename Listener>
+std::uint64_t BasicOrderbook<Listener>::ExpiryTickOf(const Order& order){
+    if (order.GetOrderType() == OrderType::GoodTillDate)
+        return ExpiryWheel::ToTick(order.GetExpiry());
+    if (order.GetOrderType() != OrderType::GoodForDay)
+        return 0;
+    if (order.GetExpiry() != Timestamp{ })
+        return ExpiryWheel::ToTick(order.GetExpiry());
+
+    // The close is cached until it passes: NextSessionClose goes through mktime
+    const auto now = std::chrono::system_clock::now();
+    if (ExpiryWheel::ToTick(now) >= sessionCloseTick_){
+        const auto close = NextSessionClose(now);
+        sessionCloseTick_ = close ? ExpiryWheel::ToTick(*close) : 0;
+    }
+    return sessionCloseTick_;
+}
+
+// Cancel an individual order
+template <typename Listener>
+bool BasicOrderbook<Listener>::CancelOrderInternal(OrderId orderId){
+    const auto handle = orders_.Erase(orderId);
+    if (handle == InvalidOrderHandle)
+        return false;
+
+    // Unlink order from its bid or ask level depending on the order side
+    listener_.OnOrderCancelled(pool_[handle]);
+    if (pool_[handle].GetSide() == Side::Buy)
+        UnlinkOrder<Side::Buy>(handle);
+    else
+        UnlinkOrder<Side::Sell>(handle);
+
+    expiries_.Cancel(handle);
+    pool_.Release(handle);
+    return true;
+}
+
+template <typename Listener>
+template <Side S>
+void BasicOrderbook<Listener>::UnlinkOrder(OrderHandle handle){
+    const auto& order = pool_[handle];
+    const auto price = order.GetPrice();
+    auto& levels = Levels<S>();
+    auto& level = *levels.Find(price);
+
+    const auto shown = pool_.Queued(handle).remaining_;
+    UpdateLevelData(level, order, shown, LevelData::Action::Remove);
+    if (const auto hidden = order.GetRemainingQuantity() - shown; hidden != 0)
+        AddHidden(S, price, -std::int64_t{ hidden });
+    pool_.Erase(level.orders_, handle);
+    if (level.Empty())
+        levels.Erase(price);
+}
+
+// Cancel from the best level down; each cancel keeps the level and its aggregates consistent
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::CancelAllInternal(Side side){
+    std::size_t cancelled{ };
+    auto CancelAll = [&](auto& levels){
+        while (!levels.Empty()){
+            CancelOrderInternal(pool_[levels.Best().orders_.head_].GetOrderId());
+            ++cancelled;
+        }
+    };
+
+    if (side == Side::Buy)
+        CancelAll(bids_);
+    else
+        CancelAll(asks_);
+    return cancelled;
+}
+
+//Update data when an order is added
+template <typename Listener>
+void BasicOrderbook<Listener>::OnOrderAdded(PriceLevel& level, const Order& order){
+    listener_.OnOrderAdded(order);
+    AddToLevelData(level, order);
+}
+
+//Update data when an order is matched
+template <typename Listener>
+void BasicOrderbook<Listener>::OnOrderMatched(PriceLevel& level, Side side, Price price, Quantity quantity, bool done){
+    UpdateLevelData(level, side, price, quantity, done ? LevelData::Action::Remove : LevelData::Action::Match);
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::AddToLevelData(PriceLevel& level, const Order& order){
+    UpdateLevelData(level, order, order.GetSliceQuantity(), LevelData::Action::Add);
+    if (const auto hidden = order.GetRemainingQuantity() - order.GetSliceQuantity(); hidden != 0)
+        AddHidden(order.GetSide(), order.GetPrice(), hidden);
+}
+
+// Hidden quantity can trade, so Fill-Or-Kill checks see it even though depth reports do not
+template <typename Listener>
+void BasicOrderbook<Listener>::AddHidden(Side side, Price price, std::int64_t delta){
+    if (side == Side::Buy)
+        bids_.AddHidden(price, delta);
+    else
+        asks_.AddHidden(price, delta);
+}
+
+// Relink the entry at the back; PushBack shows a full slice, which moves from hidden to shown
+template <typename Listener>
+void BasicOrderbook<Listener>::ReplenishOrder(PriceLevel& level, Side side, Price price, OrderHandle handle){
+    pool_.Erase(level.orders_, handle);
+    pool_.PushBack(level.orders_, handle);
+
+    const auto slice = pool_.Queued(handle).remaining_;
+    UpdateLevelData(level, side, price, slice, LevelData::Action::Replenish);
+    AddHidden(side, price, -std::int64_t{ slice });
+}
+
+//Update level data for a price level based on action type
+template <typename Listener>
+void BasicOrderbook<Listener>::UpdateLevelData(PriceLevel& level, const Order& order, Quantity quantity, LevelData::Action action){
+    UpdateLevelData(level, order.GetSide(), order.GetPrice(), quantity, action);
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::UpdateLevelData(PriceLevel& level, Side side, Price price, Quantity quantity, LevelData::Action action){
+    auto& data = level.data_;
+
+    data.count_ += action == LevelData::Action::Remove ? -1 : action == LevelData::Action::Add ? 1 : 0;
+    const bool grows = action == LevelData::Action::Add || action == LevelData::Action::Replenish;
+    if (grows){
+        data.quantity_ += quantity;
+    }else{
+        data.quantity_ -= quantity;
+    }
+    AddDepth(side, price, grows ? std::int64_t{ quantity } : -std::int64_t{ quantity });
+
+    if (deferLevels_){
+        const std::pair key{ side, price };
+        if (deferredLevels_.empty() || deferredLevels_.back() != key)
+            deferredLevels_.push_back(key);
+        return;
+    }
+    depth_.Record(side, price, data);
+    listener_.OnLevelChanged(side, price, data);
+}
+
+// Report every level a batch touched once, bids then asks by price; gone levels report empty aggregates
+template <typename Listener>
+void BasicOrderbook<Listener>::PublishDeferredLevels(){
+    std::sort(deferredLevels_.begin(), deferredLevels_.end());
+    deferredLevels_.erase(std::unique(deferredLevels_.begin(), deferredLevels_.end()), deferredLevels_.end());
+
+    for (const auto& [side, price] : deferredLevels_){
+        const auto* level = side == Side::Buy ? bids_.Find(price) : asks_.Find(price);
+        const auto data = level ? level->data_ : LevelData{ };
+        depth_.Record(side, price, data);
+        listener_.OnLevelChanged(side, price, data);
+    }
+    deferredLevels_.clear();
+}
+
+// Checks if an order can be fully filled based on liquidity availibility
+template <typename Listener>
+template <Side S>
+bool BasicOrderbook<Listener>::CanFullyFill(Price price, Quantity quantity) const{
+    if (!CanMatch<S>(price))
+        return false;
+
+    return Levels<SideTraits<S>::Opposite>().DepthTo(price) >= quantity;
+}
+
+// Keep a ladder's cumulative-depth index in step with a level's quantity
+template <typename Listener>
+void BasicOrderbook<Listener>::AddDepth(Side side, Price price, std::int64_t delta){
+    if (side == Side::Buy)
+        bids_.AddDepth(price, delta);
+    else
+        asks_.AddDepth(price, delta);
+}
+
+// Quantity resting against a limit, read from the opposite ladder's depth index
+template <typename Listener>
+std::uint64_t BasicOrderbook<Listener>::AvailableLiquidity(Side side, Price limitPrice) const{
+    const auto ordersLock = LockOrders();
+    return side == Side::Buy ? asks_.DepthTo(limitPrice) : bids_.DepthTo(limitPrice);
+}
+
+// Checks if order can be matched at the given price against the opposite best
+template <typename Listener>
+template <Side S>
+bool BasicOrderbook<Listener>::CanMatch(Price price) const{
+    const auto& opposite = Levels<SideTraits<S>::Opposite>();
+    return !opposite.Empty() && SideTraits<S>::Crosses(price, opposite.BestPrice());
+}
+
+// Walk the opposite side from its best level; resting orders fill in time priority
+template <typename Listener>
+template <Side S>
+void BasicOrderbook<Listener>::MatchIncoming(Order& order){
+    const auto start = LatencyStats::Now();
+    auto& levels = Levels<SideTraits<S>::Opposite>();
+
+    while (!order.IsFilled() && !levels.Empty()){
+        const auto price = levels.BestPrice();
+        if (!SideTraits<S>::Crosses(order.GetPrice(), price))
+            break;
+
+        auto& level = levels.Best();
+        auto& queue = level.orders_;
+        // Walk the hot queue entries; a resting order's full record is only written if it survives
+        while (!order.IsFilled() && !queue.Empty()){
+            const auto handle = queue.head_;
+            auto& resting = pool_.Queued(handle);
+        //Fill quantity is the minimum of remaining quantities of both orders
+            const Quantity quantity = std::min(order.GetRemainingQuantity(), resting.remaining_);
+
+            order.Fill(quantity);
+            resting.remaining_ -= quantity;
+
+            //Report the trade details
+            const TradeInfo incoming{ order.GetOrderId(), order.GetPrice(), quantity };
+            const TradeInfo matched{ resting.orderId_, price, quantity };
+            lastBidTrade_ = S == Side::Buy ? incoming : matched;
+            lastAskTrade_ = S == Side::Buy ? matched : incoming;
+            ++tradeCount_;
+            listener_.OnTrade(Trade{ lastBidTrade_, lastAskTrade_ });
+
+            // An order is done once its entry is used up, unless it is an Iceberg with quantity in reserve
+            const bool done = resting.remaining_ == 0 && !(resting.iceberg_ && pool_[handle].GetRemainingQuantity() != quantity);
+            OnOrderMatched(level, SideTraits<S>::Opposite, price, quantity, done);
+
+            // Remove the fully filled resting order
+            if (done){
+                orders_.Erase(resting.orderId_);
+                pool_.Erase(queue, handle);
+                expiries_.Cancel(handle);
+                pool_.Release(handle);
+            }else{
+                pool_[handle].Fill(quantity);
+                if (resting.remaining_ == 0)
+                    ReplenishOrder(level, SideTraits<S>::Opposite, price, handle);
+            }
+        }
+        if (queue.Empty())
+            levels.Erase(price);
+    }
+    latency_.RecordMatch(start);
+}
+
+// Constructor
+template <typename Listener>
+BasicOrderbook<Listener>::BasicOrderbook() : BasicOrderbook(OrderbookConfig{ }) { }
+
+template <typename Listener>
+BasicOrderbook<Listener>::BasicOrderbook(const OrderbookConfig& config, Listener listener)
+    : pool_{ config.arena_ }
+    , bids_{ config }
+    , asks_{ config }
+    , expiries_{ pool_, ExpiryWheel::ToTick(std::chrono::system_clock::now()) }
+    , depth_{ config.depthLogCapacity_ }
+    , listener_{ std::move(listener) }
+    , journal_{ config.journal_ }
+{
+    pool_.Reserve(config.orderCapacity_);
+    orders_.Reserve(config.orderCapacity_);
+
+    // Started last: the thread uses members declared after ordersPruneThread_
+    if (config.startPruneThread_)
+        ordersPruneThread_ = std::thread{ [this, core = config.pruneCore_] {
+            PinCurrentThread(core);
+            PruneExpiredOrders();
+        } };
+}
+
+// Destructor
+template <typename Listener>
+BasicOrderbook<Listener>::~BasicOrderbook(){
+    {
+        // Publish shutdown under the lock so the prune thread cannot miss the wakeup
+        std::scoped_lock ordersLock{ ordersMutex_ };
+        shutdown_.store(true, std::memory_order_release);
+    }
+    shutdownConditionVariable_.notify_one();
+    if (ordersPruneThread_.joinable())
+        ordersPruneThread_.join();
+}
+
+template <typename Listener>
+CommandStatus BasicOrderbook<Listener>::AddOrder(const Order& order){
+    const auto ordersLock = LockOrders();
+    return ProcessCommandInternal(Command::Add(order));
+}
+
+template <typename Listener>
+CommandStatus BasicOrderbook<Listener>::AddOrderInternal(const Order& incoming){
+    if (orders_.Contains(incoming.GetOrderId()))
+        return CommandStatus::DuplicateOrderId;
+
+    return incoming.GetSide() == Side::Buy ? AddOrderInternal<Side::Buy>(incoming) : AddOrderInternal<Side::Sell>(incoming);
+}
+
+template <typename Listener>
+template <Side S>
+CommandStatus BasicOrderbook<Listener>::AddOrderInternal(const Order& incoming){
+    Order order = incoming;
+    std::uint64_t expiryTick{ };
+
+    // Each order type's admission check, decided once
+    switch (order.GetOrderType()){
+        case OrderType::Market:
+            // Market orders sweep down to the worst opposite price; what is left rests there as Good-Till-Cancel
+            if (Levels<SideTraits<S>::Opposite>().Empty())
+                return CommandStatus::NoLiquidity;
+            order.ToGoodTillCancel(Levels<SideTraits<S>::Opposite>().WorstPrice());
+            break;
+        case OrderType::FillAndKill:
+            if (!CanMatch<S>(order.GetPrice()))
+                return CommandStatus::NoLiquidity;
+            break;
+        case OrderType::FillOrKill:
+            if (!CanFullyFill<S>(order.GetPrice(), order.GetInitialQuantity()))
+                return CommandStatus::CannotFullyFill;
+            break;
+        case OrderType::GoodForDay:
+        case OrderType::GoodTillDate:
+            expiryTick = ExpiryTickOf(order);
+            if (expiryTick != 0 && expiryTick <= expiries_.Current())
+                return CommandStatus::AlreadyExpired;
+            break;
+        case OrderType::GoodTillCancel:
+        case OrderType::Iceberg:
+            break;
+    }
+
+    // Trade first: only a residual that rests touches the pool, the id index and its level
+    MatchIncoming<S>(order);
+    if (order.IsFilled() || order.GetOrderType() == OrderType::FillAndKill)
+        return CommandStatus::Accepted;
+
+    const auto handle = pool_.Acquire(order);
+    auto& level = Levels<S>()[order.GetPrice()];
+    pool_.PushBack(level.orders_, handle);
+
+    // Insert the order into the main orders map for tracking by ID
+    orders_.Insert(order.GetOrderId(), handle);
+
+    OnOrderAdded(level, order);
+
+    if (expiryTick != 0){
+        expiries_.Schedule(handle, expiryTick);
+        if (expiryTick < pruneWakeTick_ && ordersPruneThread_.joinable()){
+            pruneWakeTick_ = expiryTick;
+            shutdownConditionVariable_.notify_one();
+        }
+    }
+    return CommandStatus::Accepted;
+}
+
+template <typename Listener>
+CommandStatus BasicOrderbook<Listener>::ProcessCommand(const Command& command){
+    const auto ordersLock = LockOrders();
+    return ProcessCommandInternal(command);
+}
+
+//Cancel order
+template <typename Listener>
+CommandStatus BasicOrderbook<Listener>::CancelOrder(OrderId orderId){
+    const auto ordersLock = LockOrders();
+    return ProcessCommandInternal(Command::Cancel(orderId));
+}
+
+//Modify order in place
+template <typename Listener>
+CommandStatus BasicOrderbook<Listener>::ModifyOrder(const OrderModify& order){
+    const auto ordersLock = LockOrders();
+    return ProcessCommandInternal(Command::Modify(order));
+}
+
+template <typename Listener>
+CommandStatus BasicOrderbook<Listener>::ModifyOrderInternal(const OrderModify& modify){
+    const auto handle = orders_.Find(modify.GetOrderId());
+    if (handle == InvalidOrderHandle)
+        return CommandStatus::UnknownOrderId;
+
+    auto& order = pool_[handle];
+    const auto side = order.GetSide();
+    const auto price = order.GetPrice();
+
+    // Same level and no more quantity: cut it down where it stands
+    if (modify.GetSide() == side && modify.GetPrice() == price && modify.GetQuantity() <= order.GetRemainingQuantity()){
+        auto& level = side == Side::Buy ? *bids_.Find(price) : *asks_.Find(price);
+        auto& queued = pool_.Queued(handle);
+        // An Iceberg's reserve goes first; its shown slice only shrinks once the new quantity is below it
+        const auto shown = std::min(queued.remaining_, modify.GetQuantity());
+        const auto reduction = queued.remaining_ - shown;
+        const auto hiddenCut = (order.GetRemainingQuantity() - queued.remaining_) - (modify.GetQuantity() - shown);
+        order.Amend(side, price, modify.GetQuantity());
+        queued.remaining_ = shown;
+        listener_.OnOrderModified(order, true);
+        UpdateLevelData(level, order, reduction, LevelData::Action::Reduce);
+        if (hiddenCut != 0)
+            AddHidden(side, price, -std::int64_t{ hiddenCut });
+        return CommandStatus::Accepted;
+    }
+
+    // Otherwise the record moves to the back of its new level; its handle, id entry and expiry stay
+    if (side == Side::Buy)
+        UnlinkOrder<Side::Buy>(handle);
+    else
+        UnlinkOrder<Side::Sell>(handle);
+
+    order.Amend(modify.GetSide(), modify.GetPrice(), modify.GetQuantity());
+    listener_.OnOrderModified(order, false);
+
+    // Only a new price or side can cross the book
+    const bool repriced = order.GetSide() != side || order.GetPrice() != price;
+    if (order.GetSide() == Side::Buy)
+        RequeueOrder<Side::Buy>(handle, repriced);
+    else
+        RequeueOrder<Side::Sell>(handle, repriced);
+    return CommandStatus::Accepted;
+}
+
+template <typename Listener>
+template <Side S>
+void BasicOrderbook<Listener>::RequeueOrder(OrderHandle handle, bool repriced){
+    auto& order = pool_[handle];
+    if (repriced)
+        MatchIncoming<S>(order);
+
+    if (order.IsFilled()){
+        orders_.Erase(order.GetOrderId());
+        expiries_.Cancel(handle);
+        pool_.Release(handle);
+        return;
+    }
+
+    auto& level = Levels<S>()[order.GetPrice()];
+    pool_.PushBack(level.orders_, handle);
+    AddToLevelData(level, order);
+}
+
+//Apply a command, then journal it if it was accepted
+template <typename Listener>
+CommandStatus BasicOrderbook<Listener>::ProcessCommandInternal(const Command& command){
+    const auto start = LatencyStats::Now();
+    const auto status = ApplyCommandInternal(command);
+    PublishSummary();
+    latency_.RecordCommand(command, start);
+    if (journal_ && status == CommandStatus::Accepted){
+        auto message = OrderMessage::FromCommand(command);
+        // A Good-For-Day order is journaled with the close it was given, for replay to keep rather than work out again
+        if (command.type_ == CommandType::Add && command.orderType_ == OrderType::GoodForDay && message.expiry_ == 0)
+            message.expiry_ = sessionCloseTick_;
+        journal_->Append(message);
+    }
+    return status;
+}
+
+//Apply a queued command
+template <typename Listener>
+CommandStatus BasicOrderbook<Listener>::ApplyCommandInternal(const Command& command){
+    // The same check Decode makes, so the book takes nothing the protocol would refuse
+    if (const auto status = ValidateCommand(command); status != CommandStatus::Accepted)
+        return status;
+
+    switch (command.type_){
+        case CommandType::Add:
+            if (command.orderType_ == OrderType::Iceberg)
+                return AddOrderInternal(Order{ command.orderId_, command.side_, command.price_, command.quantity_, command.displayQuantity_ });
+            return AddOrderInternal(Order{ command.orderType_, command.orderId_, command.side_, command.price_, command.quantity_, command.expiry_ });
+        case CommandType::Modify:
+            return ModifyOrderInternal(OrderModify{ command.orderId_, command.side_, command.price_, command.quantity_ });
+        case CommandType::Cancel:
+            return CancelOrderInternal(command.orderId_) ? CommandStatus::Accepted : CommandStatus::UnknownOrderId;
+        case CommandType::MassCancel:
+            CancelAllInternal(command.side_);
+            return CommandStatus::Accepted;
+    }
+    throw std::logic_error("Unsupported Command");
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::ProcessBatch(std::span<const Command> commands, std::vector<CommandStatus>& statuses){
+    statuses.clear();
+    statuses.reserve(commands.size());
+
+    const auto ordersLock = LockOrders();
+    ProcessBatchInternal(commands, [&statuses](CommandStatus status){ statuses.push_back(status); });
+}
+
+// Level aggregates stay current for matching; only their reporting waits for the end of the batch.
+// The guard only resets the deferral, so no listener runs from a destructor: if a command or
+// applied throws, the reports held back are dropped with the batch.
+template <typename Listener>
+template <typename Applied>
+void BasicOrderbook<Listener>::ProcessBatchInternal(std::span<const Command> commands, Applied&& applied){
+    struct Deferral{
+        BasicOrderbook& book_;
+        ~Deferral(){
+            book_.deferLevels_ = false;
+            book_.deferredLevels_.clear();
+        }
+    } deferral{ *this };
+
+    deferLevels_ = true;
+    for (const auto& command : commands)
+        applied(ProcessCommandInternal(command));
+
+    deferLevels_ = false;
+    PublishDeferredLevels();
+}
+
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::Replay(const JournalReader& journal){
+    const auto ordersLock = LockOrders();
+    if (orders_.Size() != 0)
+        throw std::logic_error("A journal can only be replayed into an empty book.");
+
+    // Recorded adds were accepted when made: keep them from being rejected as already expired
+    expiries_.Rewind(0);
+
+    const auto applied = ReplayInternal(journal.Records());
+    PublishSummary();
+    return applied;
+}
+
+// Records go through the checks a message gets on arrival; the first that is damaged or invalid ends the replay
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::ReplayInternal(std::span<const JournalRecord> records){
+    std::size_t applied{ };
+    for (const auto& record : records){
+        if (!record.Intact())
+            break;
+
+        Command commands[2];
+        std::size_t count = 1;
+        if (record.type_ == MessageType::Expire)
+            commands[0] = record.ToCommand();
+        else if ((count = Decode(record, commands[0], commands[1])) == 0)
+            break;
+        for (std::size_t index = 0; index < count; ++index)
+            ApplyCommandInternal(commands[index]);
+        ++applied;
+    }
+    return applied;
+}
+
+template <typename Listener>
+SnapshotTask BasicOrderbook<Listener>::Snapshot(const std::filesystem::path& path) const{
+    const auto ordersLock = LockOrders();
+
+    SnapshotHeader header;
+    header.journalPosition_ = journal_ ? journal_->Position() : 0;
+    header.bidLevels_ = bids_.Size();
+    header.askLevels_ = asks_.Size();
+    header.orders_ = orders_.Size();
+
+    return SnapshotTask::Start(path, [this, &header](SnapshotFileWriter& writer){
+        WriteSnapshotInternal(writer, header);
+    });
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::WriteSnapshotInternal(SnapshotFileWriter& writer, const SnapshotHeader& header) const{
+    writer.Write(header);
+
+    auto WriteLevels = [&writer](Side side){
+        return [&writer, side](Price price, const PriceLevel& level){
+            writer.Write(SnapshotLevel{ price, level.data_.quantity_, level.data_.count_, static_cast<std::uint8_t>(side) });
+            return true;
+        };
+    };
+    bids_.ForEach(WriteLevels(Side::Buy));
+    asks_.ForEach(WriteLevels(Side::Sell));
+
+    auto WriteOrders = [&](Price, const PriceLevel& level){
+        for (auto handle = level.orders_.head_; handle != InvalidOrderHandle; handle = pool_.Queued(handle).next_){
+            const auto& record = pool_.Get(handle);
+            const auto& order = record.order_;
+            writer.Write(SnapshotOrder{
+                order.GetOrderId(),
+                pool_.Queued(handle).expirySlot_ != 0 ? record.expiryTick_ : 0,
+                order.GetPrice(),
+                order.GetInitialQuantity(),
+                order.GetRemainingQuantity(),
+                static_cast<std::uint8_t>(order.GetOrderType()),
+                static_cast<std::uint8_t>(order.GetSide()),
+                { },
+                order.GetDisplayQuantity(),
+                pool_.Queued(handle).remaining_ });
+        }
+        return true;
+    };
+    bids_.ForEach(WriteOrders);
+    asks_.ForEach(WriteOrders);
+}
+
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::Restore(const SnapshotReader& snapshot, const JournalReader* journal){
+    const auto ordersLock = LockOrders();
+    if (orders_.Size() != 0)
+        throw std::logic_error("A snapshot can only be restored into an empty book.");
+
+    const auto position = snapshot.Header().journalPosition_;
+    if (journal && position > journal->Records().size())
+        throw std::runtime_error("Journal ends before the position of the snapshot.");
+
+    // Expiries restored or replayed were in the future when recorded: see Replay
+    expiries_.Rewind(0);
+    pool_.Reserve(snapshot.Orders().size());
+    orders_.Reserve(snapshot.Orders().size());
+
+    // The snapshot was validated when opened: levels come best first, so each one goes behind the last
+    auto order = snapshot.Orders().begin();
+    bool scheduled = false;
+    for (const auto& level : snapshot.Levels()){
+        const auto side = static_cast<Side>(level.side_);
+        auto& target = side == Side::Buy ? bids_.Append(level.price_) : asks_.Append(level.price_);
+
+        std::uint64_t hidden{ };
+        for (const auto end = order + level.count_; order != end; ++order){
+            const auto orderType = static_cast<OrderType>(order->orderType_);
+            const auto expiry = orderType == OrderType::GoodTillDate ? ExpiryWheel::ToTimestamp(order->expiryTick_) : Timestamp{ };
+            Order restored = orderType == OrderType::Iceberg
+                ? Order{ order->orderId_, side, order->price_, order->initialQuantity_, order->displayQuantity_ }
+                : Order{ orderType, order->orderId_, side, order->price_, order->initialQuantity_, expiry };
+            restored.Fill(order->initialQuantity_ - order->remainingQuantity_);
+
+            // An Iceberg comes back showing what was left of its slice, not a fresh one
+            const auto handle = pool_.Acquire(restored);
+            pool_.PushBack(target.orders_, handle);
+            pool_.Queued(handle).remaining_ = order->shownQuantity_;
+            hidden += order->remainingQuantity_ - order->shownQuantity_;
+            orders_.Insert(order->orderId_, handle);
+            if (order->expiryTick_ != 0){
+                expiries_.Schedule(handle, order->expiryTick_);
+                scheduled = true;
+            }
+        }
+
+        target.data_ = LevelData{ level.quantity_, level.count_ };
+        AddDepth(side, level.price_, level.quantity_);
+        if (hidden != 0)
+            AddHidden(side, level.price_, static_cast<std::int64_t>(hidden));
+        depth_.Record(side, level.price_, target.data_);
+        listener_.OnLevelChanged(side, level.price_, target.data_);
+    }
+
+    if (scheduled && ordersPruneThread_.joinable()){
+        pruneWakeTick_ = 0;
+        shutdownConditionVariable_.notify_one();
+    }
+
+    const auto applied = journal ? ReplayInternal(journal->Records().subspan(position)) : 0;
+    PublishSummary();
+    return applied;
+}
+
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::Size() const{
+    return summary_.Load().orders_;
+}
+
+template <typename Listener>
+BookSummary BasicOrderbook<Listener>::GetSummary() const{
+    return summary_.Load();
+}
+
+// Built from the O(1) best-level caches and counters, so publishing costs a few loads per command
+template <typename Listener>
+void BasicOrderbook<Listener>::PublishSummary(){
+    BookSummary summary;
+    summary.version_ = ++summaryVersion_;
+    if (!bids_.Empty()){
+        summary.bestBid_ = bids_.BestPrice();
+        summary.bestBidQuantity_ = bids_.Best().data_.quantity_;
+    }
+    if (!asks_.Empty()){
+        summary.bestAsk_ = asks_.BestPrice();
+        summary.bestAskQuantity_ = asks_.Best().data_.quantity_;
+    }
+    summary.bidLevels_ = static_cast<std::uint32_t>(bids_.Size());
+    summary.askLevels_ = static_cast<std::uint32_t>(asks_.Size());
+    summary.orders_ = orders_.Size();
+    summary.trades_ = tradeCount_;
+    summary.lastBidTrade_ = lastBidTrade_;
+    summary.lastAskTrade_ = lastAskTrade_;
+    summary_.Store(summary);
+}
+
+template <typename Listener>
+OrderIdIndexStats BasicOrderbook<Listener>::GetOrderIndexStats() const{
+    const auto ordersLock = LockOrders();
+    return orders_.GetStats();
+}
+
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::ExpireOrders(Timestamp now){
+    const auto ordersLock = LockOrders();
+    return ExpireOrdersInternal(ExpiryWheel::ToTick(now));
+}
+
+template <typename Listener>
+OrderbookLevelInfos BasicOrderbook<Listener>::GetOrderInfos() const{
+    const auto ordersLock = LockOrders();
+    return CollectLevels(std::max(bids_.Size(), asks_.Size()));
+}
+
+template <typename Listener>
+OrderbookLevelInfos BasicOrderbook<Listener>::GetTopLevels(std::size_t depth) const{
+    const auto ordersLock = LockOrders();
+    return CollectLevels(depth);
+}
+
+template <typename Listener>
+OrderbookLevelInfos BasicOrderbook<Listener>::CollectLevels(std::size_t depth) const{
+    LevelInfos bidInfos, askInfos;
+    bidInfos.reserve(std::min(depth, bids_.Size()));
+    askInfos.reserve(std::min(depth, asks_.Size()));
+
+    // Levels keep their total quantity up to date, so no order is visited
+    bids_.ForEach([&](Price price, const PriceLevel& level){
+        if (bidInfos.size() == depth)
+            return false;
+        bidInfos.push_back(LevelInfo{ price, level.data_.quantity_ });
+        return true;
+    });
+
+    asks_.ForEach([&](Price price, const PriceLevel& level){
+        if (askInfos.size() == depth)
+            return false;
+        askInfos.push_back(LevelInfo{ price, level.data_.quantity_ });
+        return true;
+    });
+
+    return OrderbookLevelInfos{ bidInfos, askInfos, depth_.Sequence() };
+}
+
+template <typename Listener>
+std::optional<LevelInfo> BasicOrderbook<Listener>::GetBestBid() const{
+    const auto summary = summary_.Load();
+    if (summary.bidLevels_ == 0)
+        return std::nullopt;
+    return LevelInfo{ summary.bestBid_, summary.bestBidQuantity_ };
+}
+
+template <typename Listener>
+std::optional<LevelInfo> BasicOrderbook<Listener>::GetBestAsk() const{
+    const auto summary = summary_.Load();
+    if (summary.askLevels_ == 0)
+        return std::nullopt;
+    return LevelInfo{ summary.bestAsk_, summary.bestAskQuantity_ };
+}
+
+template <typename Listener>
+std::optional<std::uint64_t> BasicOrderbook<Listener>::GetDepthChanges(std::uint64_t since, LevelChanges& changes) const{
+    const auto ordersLock = LockOrders();
+    return depth_.ChangesSince(since, changes);
+}
 
+template <typename Listener>
+LatencyReport BasicOrderbook<Listener>::GetLatencyStats() const{
+    return latency_.Report();
+}
 
-};
\ No newline at end of file
+template <typename Listener>
+void BasicOrderbook<Listener>::ResetLatencyStats(){
+    latency_.Reset();
+}
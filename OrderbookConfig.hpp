@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Using.hpp"
+
+class JournalWriter;
+class HugePageArena;
+
+/**
+ * @struct OrderbookConfig
+ * @brief Construction-time settings of an Orderbook.
+ *
+ * The price ladder covers prices basePrice_ + i * tickSize_ for i in [0, levelCount_).
+ * Prices outside that band, or off the tick grid, fall back to an ordered map, so a
+ * levelCount_ of zero keeps every level in the map.
+ */
+struct OrderbookConfig{
+    Price basePrice_{ };         ///< Lowest price held in the dense ladder.
+    Price tickSize_{ 1 };        ///< Price distance between adjacent ladder slots.
+    std::size_t levelCount_{ };  ///< Number of dense ladder slots per side.
+    std::size_t orderCapacity_{ }; ///< Live orders to pre-size the pool and id index for.
+    std::size_t depthLogCapacity_{ 1 << 12 }; ///< Level changes retained for GetDepthChanges; 0 disables the log.
+    JournalWriter* journal_{ };  ///< Receives every accepted command and expiry; must outlive the book. Optional.
+    bool startPruneThread_{ true }; ///< Run the thread that cancels orders as they expire; on since a book used alone has nothing else to expire them. MatchingEngine and OrderbookPipeline turn it off.
+    int pruneCore_{ -1 };        ///< Core to pin the prune thread to; negative leaves it unpinned.
+    HugePageArena* arena_{ };    ///< Supplies the order pool's chunks and the ladders' slots; must outlive the book. Optional.
+};
@@ -0,0 +1,127 @@
+#include "OrderbookPipeline.hpp"
+
+namespace{
+    // Commands applied between expiry checks while the ring stays busy
+    constexpr std::uint64_t ExpiryCheckInterval = 64;
+
+    OrderbookConfig ForPipeline(OrderbookConfig config, HugePageArena* arena){
+        config.startPruneThread_ = false;
+        if (arena)
+            config.arena_ = arena;
+        return config;
+    }
+}
+
+OrderbookPipeline::OrderbookPipeline(const OrderbookConfig& bookConfig, const PipelineConfig& config, std::vector<EventHandler> handlers)
+    : arena_{ config.hugePages_ ? std::make_unique<HugePageArena>(NodeOfCore(config.matchingCore_)) : nullptr }
+    , idle_{ config.idle_ }
+    , orderbook_{ ForPipeline(bookConfig, arena_.get()) }
+    , commands_{ config.commandCapacity_, arena_.get() }
+    , events_{ config.eventCapacity_, handlers.size(), arena_.get() }
+    , handlers_{ std::move(handlers) }
+{
+    for (std::size_t consumer = 0; consumer < handlers_.size(); ++consumer){
+        const int core = consumer < config.consumerCores_.size() ? config.consumerCores_[consumer] : -1;
+        consumerThreads_.emplace_back([this, consumer, core] { RunConsumer(consumer, core, handlers_[consumer]); });
+    }
+
+    matchingThread_ = std::thread{ [this, core = config.matchingCore_] { RunMatching(core); } };
+}
+
+OrderbookPipeline::~OrderbookPipeline(){
+    running_.store(false, std::memory_order_release);
+    matchingThread_.join();
+
+    matchingDone_.store(true, std::memory_order_release);
+    for (auto& consumer : consumerThreads_)
+        consumer.join();
+}
+
+bool OrderbookPipeline::TrySubmit(const Command& command, std::uint64_t& sequence){
+    return commands_.TryPublish(command, sequence);
+}
+
+std::uint64_t OrderbookPipeline::Submit(const Command& command){
+    return commands_.Publish(command);
+}
+
+void OrderbookPipeline::Flush() const{
+    const auto target = commands_.Claimed();
+    while (processed_.load(std::memory_order_acquire) < target)
+        std::this_thread::yield();
+}
+
+// Single writer: drains the command ring and applies each command to the book without locking
+void OrderbookPipeline::RunMatching(int core){
+    using namespace std::chrono;
+
+    PinCurrentThread(core);
+
+    auto& trades = orderbook_.GetListener().GetTrades();
+    Command command;
+    SpinBackoff backoff{ idle_ };
+
+    while (true){
+        if (commands_.TryConsume(command)){
+            backoff.Reset();
+            trades.clear();
+
+            const auto sequence = processed_.load(std::memory_order_relaxed);
+            if (sequence % ExpiryCheckInterval == 0)
+                orderbook_.ExpireOrdersInternal(ExpiryWheel::ToTick(system_clock::now()));
+
+            const auto status = orderbook_.ProcessCommandInternal(command);
+            Publish(sequence, command, status, trades);
+            processed_.store(sequence + 1, std::memory_order_release);
+            continue;
+        }
+
+        if (!running_.load(std::memory_order_acquire) && processed_.load(std::memory_order_relaxed) == commands_.Claimed())
+            return;
+
+        // Idle: expire what has come due, then back off
+        orderbook_.ExpireOrdersInternal(ExpiryWheel::ToTick(system_clock::now()));
+
+        backoff.Pause();
+    }
+}
+
+void OrderbookPipeline::RunConsumer(std::size_t consumer, int core, const EventHandler& handler){
+    PinCurrentThread(core);
+
+    PipelineEvent event;
+    SpinBackoff backoff{ idle_ };
+    while (true){
+        if (events_.TryRead(consumer, event)){
+            handler(event);
+            backoff.Reset();
+            continue;
+        }
+
+        // The matching thread has published its last event: drain what is left and stop
+        if (matchingDone_.load(std::memory_order_acquire)){
+            while (events_.TryRead(consumer, event))
+                handler(event);
+            return;
+        }
+
+        backoff.Pause();
+    }
+}
+
+void OrderbookPipeline::Publish(std::uint64_t sequence, const Command& command, CommandStatus status, const Trades& trades){
+    PipelineEvent event;
+    event.sequence_ = sequence;
+    event.command_ = command.type_;
+    event.status_ = status;
+    event.orderId_ = command.orderId_;
+    event.type_ = status == CommandStatus::Accepted ? PipelineEventType::Accepted : PipelineEventType::Rejected;
+    events_.Publish(event);
+
+    event.type_ = PipelineEventType::Trade;
+    for (const auto& trade : trades){
+        event.bidTrade_ = trade.GetBidTrade();
+        event.askTrade_ = trade.GetAskTrade();
+        events_.Publish(event);
+    }
+}
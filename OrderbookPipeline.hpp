@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Orderbook.hpp"
+#include "Command.hpp"
+#include "Ring.hpp"
+#include "HugePageArena.hpp"
+#include "ThreadAffinity.hpp"
+
+/**
+ * @enum PipelineEventType
+ * @brief Kinds of event a pipeline publishes to its consumers.
+ */
+enum class PipelineEventType{
+    Accepted, ///< A command was applied.
+    Rejected, ///< A command was refused; status_ says why.
+    Trade,    ///< A trade resulting from the command with the same sequence.
+};
+
+/**
+ * @struct PipelineEvent
+ * @brief Result of a command, published on the pipeline's output ring.
+ */
+struct PipelineEvent{
+    std::uint64_t sequence_{ };  ///< Sequence returned by Submit for the originating command.
+    PipelineEventType type_{ };
+    CommandType command_{ };
+    CommandStatus status_{ };
+    OrderId orderId_{ };         ///< Id the command referred to.
+    TradeInfo bidTrade_{ };      ///< Bid side of the trade (Trade events only).
+    TradeInfo askTrade_{ };      ///< Ask side of the trade (Trade events only).
+};
+
+/**
+ * @struct PipelineConfig
+ * @brief Ring sizes, thread placement and memory placement of an OrderbookPipeline.
+ */
+struct PipelineConfig{
+    std::size_t commandCapacity_{ 1 << 16 }; ///< Slots of the input ring.
+    std::size_t eventCapacity_{ 1 << 16 };   ///< Slots of the output ring.
+    int matchingCore_{ -1 };                 ///< Core to pin the matching thread to; negative leaves it unpinned.
+    std::vector<int> consumerCores_{ };      ///< Core to pin each consumer thread to, by handler index; missing entries stay unpinned.
+    IdleStrategy idle_{ IdleStrategy::Backoff }; ///< How the matching and consumer threads wait for work.
+    bool hugePages_{ false };                ///< Take the book's pool and ladders and both rings from 2 MB pages on the matching core's NUMA node.
+};
+
+/**
+ * @class OrderbookPipeline
+ * @brief Staged front end for one Orderbook: producers -> command ring -> matching thread -> event ring -> consumers.
+ *
+ * Any number of threads submit commands into a pre-allocated lock-free ring. One matching thread
+ * is the only writer of the book, so it applies commands without taking the book's mutex, and it
+ * also expires Good-For-Day and Good-Till-Date orders itself instead of a separate prune thread. Every
+ * command produces an Accepted or Rejected event followed by its trades; each consumer handler runs
+ * on its own thread and sees every event in order.
+ *
+ * With hugePages_ set, the pipeline owns a HugePageArena on the matching core's node and the book's
+ * order pool, price ladders and both rings are allocated from it; the arena falls back to regular
+ * pages when the host has no huge pages.
+ */
+class OrderbookPipeline{
+public:
+    using EventHandler = std::function<void(const PipelineEvent&)>;
+
+    /**
+     * @brief Creates the book and starts the matching and consumer threads.
+     * @param bookConfig Settings of the book; its prune thread is always disabled.
+     * @param config Ring sizes and thread placement.
+     * @param handlers One consumer thread is started per handler.
+     */
+    OrderbookPipeline(const OrderbookConfig& bookConfig, const PipelineConfig& config, std::vector<EventHandler> handlers = { });
+
+    OrderbookPipeline(const OrderbookPipeline&) = delete;
+    void operator=(const OrderbookPipeline&) = delete;
+    OrderbookPipeline(OrderbookPipeline&&) = delete;
+    void operator=(OrderbookPipeline&&) = delete;
+
+    /**
+     * @brief Processes everything already submitted, then stops all threads.
+     */
+    ~OrderbookPipeline();
+
+    /**
+     * @brief Enqueues a command if the ring has room. Safe to call from any thread.
+     * @param command The command to enqueue.
+     * @param sequence Receives the sequence the command's events will carry.
+     * @return False if the ring is full.
+     */
+    bool TrySubmit(const Command& command, std::uint64_t& sequence);
+
+    /**
+     * @brief Enqueues a command, waiting while the ring is full. Safe to call from any thread.
+     * @param command The command to enqueue.
+     * @return The sequence the command's events will carry.
+     */
+    std::uint64_t Submit(const Command& command);
+
+    /**
+     * @brief Blocks until every command submitted before the call has been applied to the book.
+     */
+    void Flush() const;
+
+    /**
+     * @brief The book driven by the pipeline. Only safe to inspect after Flush() with no producers running.
+     */
+    const Orderbook& GetOrderbook() const { return orderbook_; }
+
+    /**
+     * @brief The arena the book and rings were allocated from, or nullptr without hugePages_.
+     */
+    const HugePageArena* GetArena() const { return arena_.get(); }
+
+private:
+    void RunMatching(int core);
+    void RunConsumer(std::size_t consumer, int core, const EventHandler& handler);
+    void Publish(std::uint64_t sequence, const Command& command, CommandStatus status, const Trades& trades);
+
+    std::unique_ptr<HugePageArena> arena_;
+    IdleStrategy idle_;
+    Orderbook orderbook_;
+    MpscRing<Command> commands_;
+    BroadcastRing<PipelineEvent> events_;
+    std::vector<EventHandler> handlers_;
+    alignas(CacheLineSize) std::atomic<std::uint64_t> processed_{ };
+    std::atomic<bool> running_{ true };
+    std::atomic<bool> matchingDone_{ false };
+    std::thread matchingThread_;
+    std::vector<std::thread> consumerThreads_;
+};
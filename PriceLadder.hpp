@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Using.hpp"
+#include "PriceLevel.hpp"
+#include "OrderbookConfig.hpp"
+#include "HugePageArena.hpp"
+#include "CompressedDepth.hpp"
+
+/**
+ * @class PriceLadder
+ * @brief One side of the book: price levels ordered best first according to Compare.
+ *
+ * Prices on the configured tick grid live in a contiguous array indexed by
+ * (price - base) / tick. A two-level bitmap (one bit per slot, one summary bit per
+ * 64 slots) marks the non-empty slots, so finding the next level is a word scan
+ * instead of a tree walk. The best slot is cached, making best-price lookups O(1).
+ * Everything off the grid is kept in an ordered map and merged in on iteration.
+ * A Fenwick tree over the slots and a CompressedDepth over the off-grid prices hold the cumulative
+ * quantity, hidden Iceberg quantity included, so the depth available up to a price costs
+ * O(log slots + log off-grid levels).
+ *
+ * @tparam Compare std::greater<Price> for bids, std::less<Price> for asks.
+ */
+template <typename Compare>
+class PriceLadder{
+public:
+    explicit PriceLadder(const OrderbookConfig& config)
+        : base_{ config.basePrice_ }
+        , tick_{ config.tickSize_ > 0 ? config.tickSize_ : 1 }
+        , levels_(config.levelCount_, ArenaAllocator<PriceLevel>{ config.arena_ })
+        , words_((config.levelCount_ + 63) / 64, ArenaAllocator<std::uint64_t>{ config.arena_ })
+        , summary_((words_.size() + 63) / 64, ArenaAllocator<std::uint64_t>{ config.arena_ })
+        , depth_(config.levelCount_ + 1, ArenaAllocator<std::uint64_t>{ config.arena_ })
+    { }
+
+    /**
+     * @brief Checks if the side has no level.
+     * @return True / false.
+     */
+    bool Empty() const { return size_ == 0; }
+
+    /**
+     * @brief Number of non-empty levels.
+     */
+    std::size_t Size() const { return size_; }
+
+    /**
+     * @brief Finds the level at a price.
+     * @param price Price of the level.
+     * @return Pointer to the level, or nullptr if no order rests there.
+     */
+    PriceLevel* Find(Price price){
+        if (const auto index = IndexOf(price); index != npos)
+            return IsSet(index) ? &levels_[index] : nullptr;
+
+        auto level = overflow_.find(price);
+        return level == overflow_.end() ? nullptr : &level->second;
+    }
+
+    const PriceLevel* Find(Price price) const{
+        if (const auto index = IndexOf(price); index != npos)
+            return IsSet(index) ? &levels_[index] : nullptr;
+
+        const auto level = overflow_.find(price);
+        return level == overflow_.end() ? nullptr : &level->second;
+    }
+
+    /**
+     * @brief Gets the level at a price, creating it when empty.
+     * @param price Price of the level.
+     * @return Reference to the level.
+     */
+    PriceLevel& operator[](Price price){
+        if (const auto index = IndexOf(price); index != npos){
+            if (!IsSet(index))
+                Set(index);
+            return levels_[index];
+        }
+
+        auto [level, inserted] = overflow_.try_emplace(price);
+        if (inserted)
+            ++size_;
+        return level->second;
+    }
+
+    /**
+     * @brief Creates a level behind every existing one, for building a side best first in O(1) per level.
+     * @param price Price of the level; worse than every non-empty level.
+     * @return Reference to the new level.
+     */
+    PriceLevel& Append(Price price){
+        if (const auto index = IndexOf(price); index != npos){
+            Set(index);
+            return levels_[index];
+        }
+
+        ++size_;
+        return overflow_.emplace_hint(overflow_.end(), price, PriceLevel{ })->second;
+    }
+
+    /**
+     * @brief Removes the level at a price. The level's queue must be empty.
+     * @param price Price of the level.
+     */
+    void Erase(Price price){
+        if (const auto index = IndexOf(price); index != npos){
+            if (IsSet(index)){
+                levels_[index] = PriceLevel{ };
+                Clear(index);
+            }
+            return;
+        }
+
+        if (overflow_.erase(price))
+            --size_;
+    }
+
+    /**
+     * @brief Price of the best level. The side must not be empty.
+     */
+    Price BestPrice() const{
+        if (best_ == npos)
+            return overflow_.begin()->first;
+        if (overflow_.empty())
+            return PriceOf(best_);
+
+        const auto ladderBest = PriceOf(best_);
+        const auto overflowBest = overflow_.begin()->first;
+        return Compare{ }(overflowBest, ladderBest) ? overflowBest : ladderBest;
+    }
+
+    /**
+     * @brief The best level, without a lookup by price. The side must not be empty.
+     */
+    PriceLevel& Best() { return const_cast<PriceLevel&>(std::as_const(*this).Best()); }
+
+    const PriceLevel& Best() const{
+        if (best_ == npos)
+            return overflow_.begin()->second;
+        if (overflow_.empty() || !Compare{ }(overflow_.begin()->first, PriceOf(best_)))
+            return levels_[best_];
+        return overflow_.begin()->second;
+    }
+
+    /**
+     * @brief Price of the worst level. The side must not be empty.
+     */
+    Price WorstPrice() const{
+        const auto worst = Descending ? FindUp(0) : FindDown(levels_.size() - 1);
+        if (worst == npos)
+            return overflow_.rbegin()->first;
+        if (overflow_.empty())
+            return PriceOf(worst);
+
+        const auto ladderWorst = PriceOf(worst);
+        const auto overflowWorst = overflow_.rbegin()->first;
+        return Compare{ }(ladderWorst, overflowWorst) ? overflowWorst : ladderWorst;
+    }
+
+    /**
+     * @brief Records a change of a level's total quantity in the cumulative-depth index.
+     * Called by the owner whenever it changes a level's data_.quantity_.
+     * @param price Price of the level.
+     * @param delta Signed change of its quantity.
+     */
+    void AddDepth(Price price, std::int64_t delta){
+        const auto index = IndexOf(price);
+        if (index == npos){
+            overflowDepth_.Add(price, delta);
+            return;
+        }
+        for (auto node = index + 1; node < depth_.size(); node += node & (~node + 1))
+            depth_[node] += static_cast<std::uint64_t>(delta);
+    }
+
+    /**
+     * @brief Records a change of the hidden Iceberg quantity at a price, which trades but is not in data_.
+     * @param price Price of the level.
+     * @param delta Signed change of the hidden quantity.
+     */
+    void AddHidden(Price price, std::int64_t delta) { AddDepth(price, delta); }
+
+    /**
+     * @brief Total quantity resting at prices at least as good as a limit, i.e. what an
+     * opposite order limited at that price could trade against, hidden Iceberg quantity included.
+     * @param limit The limit price.
+     */
+    std::uint64_t DepthTo(Price limit) const{
+        std::uint64_t quantity{ };
+        if (!levels_.empty()){
+            // Slots are in ascending price: asks qualify up to the limit, bids from it upwards
+            const auto offset = static_cast<std::int64_t>(limit) - base_;
+            const auto slots = static_cast<std::int64_t>(levels_.size());
+            if (Descending){
+                const auto first = offset <= 0 ? 0 : std::min((offset + tick_ - 1) / tick_, slots);
+                quantity = PrefixDepth(static_cast<std::size_t>(slots)) - PrefixDepth(static_cast<std::size_t>(first));
+            }else if (offset >= 0)
+                quantity = PrefixDepth(static_cast<std::size_t>(std::min(offset / tick_ + 1, slots)));
+        }
+
+        return quantity + overflowDepth_.SumTo(limit);
+    }
+
+    /**
+     * @brief Visits non-empty levels best first, merging ladder and overflow levels.
+     * @param visit Called as visit(price, level); returning false stops the walk.
+     */
+    template <typename Visitor>
+    void ForEach(Visitor&& visit) const{
+        auto index = best_;
+        auto overflow = overflow_.begin();
+
+        while (index != npos || overflow != overflow_.end()){
+            const bool takeOverflow = index == npos ||
+                (overflow != overflow_.end() && Compare{ }(overflow->first, PriceOf(index)));
+
+            if (takeOverflow){
+                if (!visit(overflow->first, static_cast<const PriceLevel&>(overflow->second)))
+                    return;
+                ++overflow;
+            }else{
+                if (!visit(PriceOf(index), static_cast<const PriceLevel&>(levels_[index])))
+                    return;
+                index = NextAfter(index);
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    static constexpr bool Descending = Compare{ }(1, 0);
+
+    // Total quantity of the first count slots.
+    std::uint64_t PrefixDepth(std::size_t count) const{
+        std::uint64_t quantity{ };
+        for (auto node = count; node > 0; node &= node - 1)
+            quantity += depth_[node];
+        return quantity;
+    }
+
+    // Slot of a price, or npos when it is off the band or off the tick grid.
+    std::size_t IndexOf(Price price) const{
+        const auto offset = static_cast<std::int64_t>(price) - base_;
+        if (offset < 0 || offset % tick_ != 0)
+            return npos;
+
+        const auto index = static_cast<std::size_t>(offset / tick_);
+        return index < levels_.size() ? index : npos;
+    }
+
+    Price PriceOf(std::size_t index) const { return static_cast<Price>(base_ + static_cast<std::int64_t>(index) * tick_); }
+
+    bool IsSet(std::size_t index) const { return (words_[index >> 6] >> (index & 63)) & 1; }
+
+    bool IsBetter(std::size_t lhs, std::size_t rhs) const { return Descending ? lhs > rhs : lhs < rhs; }
+
+    void Set(std::size_t index){
+        const auto word = index >> 6;
+        words_[word] |= std::uint64_t{ 1 } << (index & 63);
+        summary_[word >> 6] |= std::uint64_t{ 1 } << (word & 63);
+        ++size_;
+
+        if (best_ == npos || IsBetter(index, best_))
+            best_ = index;
+    }
+
+    void Clear(std::size_t index){
+        const auto word = index >> 6;
+        words_[word] &= ~(std::uint64_t{ 1 } << (index & 63));
+        if (words_[word] == 0)
+            summary_[word >> 6] &= ~(std::uint64_t{ 1 } << (word & 63));
+        --size_;
+
+        if (index == best_)
+            best_ = NextAfter(index);
+    }
+
+    // Next occupied slot in priority order after index.
+    std::size_t NextAfter(std::size_t index) const{
+        if (Descending)
+            return index == 0 ? npos : FindDown(index - 1);
+        return FindUp(index + 1);
+    }
+
+    // First occupied slot at or above from.
+    std::size_t FindUp(std::size_t from) const{
+        if (from >= levels_.size())
+            return npos;
+
+        auto word = from >> 6;
+        if (const auto bits = words_[word] & (~std::uint64_t{ 0 } << (from & 63)))
+            return (word << 6) + std::countr_zero(bits);
+
+        if (++word >= words_.size())
+            return npos;
+
+        auto group = word >> 6;
+        auto bits = summary_[group] & (~std::uint64_t{ 0 } << (word & 63));
+        while (bits == 0){
+            if (++group >= summary_.size())
+                return npos;
+            bits = summary_[group];
+        }
+
+        word = (group << 6) + std::countr_zero(bits);
+        return (word << 6) + std::countr_zero(words_[word]);
+    }
+
+    // Last occupied slot at or below from.
+    std::size_t FindDown(std::size_t from) const{
+        if (levels_.empty())
+            return npos;
+        if (from >= levels_.size())
+            from = levels_.size() - 1;
+
+        auto word = from >> 6;
+        if (const auto bits = words_[word] & (~std::uint64_t{ 0 } >> (63 - (from & 63))))
+            return (word << 6) + 63 - std::countl_zero(bits);
+
+        if (word-- == 0)
+            return npos;
+
+        auto group = word >> 6;
+        auto bits = summary_[group] & (~std::uint64_t{ 0 } >> (63 - (word & 63)));
+        while (bits == 0){
+            if (group-- == 0)
+                return npos;
+            bits = summary_[group];
+        }
+
+        word = (group << 6) + 63 - std::countl_zero(bits);
+        return (word << 6) + 63 - std::countl_zero(words_[word]);
+    }
+
+    std::int64_t base_;
+    std::int64_t tick_;
+    ArenaVector<PriceLevel> levels_;
+    ArenaVector<std::uint64_t> words_;
+    ArenaVector<std::uint64_t> summary_;
+    ArenaVector<std::uint64_t> depth_;   ///< Fenwick tree of slot quantities, 1-based.
+    std::map<Price, PriceLevel, Compare> overflow_;
+    CompressedDepth<Compare> overflowDepth_;   ///< Quantity of off-grid levels, hidden Iceberg quantity included.
+    std::size_t best_{ npos };
+    std::size_t size_{ };
+};
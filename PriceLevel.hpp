@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Using.hpp"
+#include "OrderPool.hpp"
+
+/**
+ * @struct LevelData
+ * @brief Data at each price level, like the total quantity and order count.
+ */
+struct LevelData{
+    Quantity quantity_{ };
+    Quantity count_{ };
+
+    /**
+     * @enum Action
+     * @brief Actions that affect level data (adding, removing, or matching) orders.
+     */
+    enum class Action{
+        Add,
+        Remove,
+        Match,
+        Reduce, ///< Resting quantity cut by a modify, the order keeping its place.
+        Replenish, ///< An Iceberg order showed a new slice of its hidden quantity.
+    };
+};
+
+/**
+ * @struct PriceLevel
+ * @brief One price level: its order queue and its aggregates kept side by side.
+ */
+struct PriceLevel{
+    OrderList orders_;
+    LevelData data_;
+
+    /**
+     * @brief Checks if no order rests at this level.
+     * @return True / false.
+     */
+    bool Empty() const { return orders_.Empty(); }
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "Using.hpp"
+#include "Command.hpp"
+#include "Trade.hpp"
+#include "BookListener.hpp"
+#include "ExpiryWheel.hpp"
+
+static_assert(std::endian::native == std::endian::little, "Protocol messages are encoded in host byte order, which must be little-endian.");
+
+/**
+ * @enum MessageType
+ * @brief First byte of every protocol message.
+ */
+enum class MessageType : std::uint8_t{
+    NewOrder = 'N',    ///< Inbound: add an order.
+    ModifyOrder = 'M', ///< Inbound: replace price, side and quantity of a resting order.
+    CancelOrder = 'C', ///< Inbound: remove a resting order.
+    MassCancel = 'X',  ///< Inbound: remove every resting order of one side, or of both.
+    Expire = 'E',      ///< Journal only: a resting order reached its expiry.
+    Ack = 'A',         ///< Outbound: the command was applied.
+    Reject = 'J',      ///< Outbound: the command was refused; status_ says why.
+    Execution = 'F',   ///< Outbound: one side of a trade.
+};
+
+/**
+ * @brief Side byte of a MassCancel message that selects both sides.
+ */
+inline constexpr std::uint8_t BothSides = 2;
+
+/**
+ * @struct OrderMessage
+ * @brief Fixed-width inbound message; also the record format of the journal.
+ *
+ * Every inbound message is 32 bytes so a stream of them can be read in place, and so a
+ * journal is simply the accepted messages in the order they were applied.
+ */
+struct OrderMessage{
+    MessageType type_{ MessageType::NewOrder };
+    std::uint8_t orderType_{ };
+    std::uint8_t side_{ };
+    std::uint8_t reserved_{ };
+    Price price_{ };
+    OrderId orderId_{ };
+    Quantity quantity_{ };
+    std::uint32_t delay_{ };    ///< Microseconds after the previous message in a recorded workload, for paced replay.
+    std::uint64_t expiry_{ };   ///< Expiry in milliseconds since the epoch of Good-Till-Date orders, and of Good-For-Day orders given their close; display quantity of Iceberg orders.
+
+    /**
+     * @brief Message carrying a command. A mass cancel keeps its side.
+     * @param command The command.
+     */
+    static OrderMessage FromCommand(const Command& command){
+        OrderMessage message;
+        switch (command.type_){
+            case CommandType::Add: message.type_ = MessageType::NewOrder; break;
+            case CommandType::Modify: message.type_ = MessageType::ModifyOrder; break;
+            case CommandType::Cancel: message.type_ = MessageType::CancelOrder; break;
+            case CommandType::MassCancel: message.type_ = MessageType::MassCancel; break;
+        }
+        message.orderType_ = static_cast<std::uint8_t>(command.orderType_);
+        message.side_ = static_cast<std::uint8_t>(command.side_);
+        message.price_ = command.price_;
+        message.orderId_ = command.orderId_;
+        message.quantity_ = command.quantity_;
+        if (command.orderType_ == OrderType::GoodTillDate || command.orderType_ == OrderType::GoodForDay)
+            message.expiry_ = ExpiryWheel::ToTick(command.expiry_);
+        else if (command.orderType_ == OrderType::Iceberg)
+            message.expiry_ = command.displayQuantity_;
+        return message;
+    }
+
+    /**
+     * @brief Journal record of an order that expired.
+     * @param orderId Id of the order.
+     */
+    static OrderMessage Expired(OrderId orderId){
+        OrderMessage message;
+        message.type_ = MessageType::Expire;
+        message.orderId_ = orderId;
+        return message;
+    }
+
+    /**
+     * @brief The command of a message known to be valid; an expiry becomes a cancel.
+     * A mass cancel of both sides yields the buy side only; see Decode.
+     */
+    Command ToCommand() const{
+        auto type = CommandType::Cancel;
+        switch (type_){
+            case MessageType::NewOrder: type = CommandType::Add; break;
+            case MessageType::ModifyOrder: type = CommandType::Modify; break;
+            case MessageType::MassCancel: type = CommandType::MassCancel; break;
+            default: break;
+        }
+        const auto side = side_ == static_cast<std::uint8_t>(Side::Sell) ? Side::Sell : Side::Buy;
+        const auto orderType = static_cast<OrderType>(orderType_);
+        if (orderType == OrderType::Iceberg)
+            return Command{ type, orderType, orderId_, side, price_, quantity_, Timestamp{ }, static_cast<Quantity>(expiry_) };
+        return Command{ type, orderType, orderId_, side, price_, quantity_, ExpiryWheel::ToTimestamp(expiry_) };
+    }
+};
+
+/**
+ * @struct ReportMessage
+ * @brief Fixed-width outbound message: an ack, a reject or an execution.
+ */
+struct ReportMessage{
+    MessageType type_{ MessageType::Ack };
+    std::uint8_t status_{ };    ///< CommandStatus of a reject.
+    std::uint8_t side_{ };      ///< Side of the order an execution belongs to.
+    std::uint8_t reserved_{ };
+    Price price_{ };            ///< Execution price.
+    OrderId orderId_{ };
+    Quantity quantity_{ };      ///< Executed quantity.
+    std::uint32_t padding_{ };
+    OrderId matchOrderId_{ };   ///< Order on the other side of an execution.
+};
+
+static_assert(sizeof(OrderMessage) == 32 && std::is_trivially_copyable_v<OrderMessage>);
+static_assert(sizeof(ReportMessage) == 32 && std::is_trivially_copyable_v<ReportMessage>);
+
+/**
+ * @brief Ack of an applied command.
+ * @param orderId Order the command was about; zero for a mass cancel.
+ */
+inline ReportMessage EncodeAck(OrderId orderId){
+    return ReportMessage{ .type_ = MessageType::Ack, .orderId_ = orderId };
+}
+
+/**
+ * @brief Reject of a refused command.
+ * @param orderId Order the command was about.
+ * @param status Why it was refused.
+ */
+inline ReportMessage EncodeReject(OrderId orderId, CommandStatus status){
+    return ReportMessage{ .type_ = MessageType::Reject, .status_ = static_cast<std::uint8_t>(status), .orderId_ = orderId };
+}
+
+/**
+ * @brief The two executions of a trade, bid side first.
+ * @param trade The trade.
+ */
+inline std::pair<ReportMessage, ReportMessage> EncodeExecutions(const Trade& trade){
+    const auto& bid = trade.GetBidTrade();
+    const auto& ask = trade.GetAskTrade();
+    return {
+        ReportMessage{ .type_ = MessageType::Execution, .side_ = static_cast<std::uint8_t>(Side::Buy), .price_ = bid.price_,
+            .orderId_ = bid.orderId_, .quantity_ = bid.quantity_, .matchOrderId_ = ask.orderId_ },
+        ReportMessage{ .type_ = MessageType::Execution, .side_ = static_cast<std::uint8_t>(Side::Sell), .price_ = ask.price_,
+            .orderId_ = ask.orderId_, .quantity_ = ask.quantity_, .matchOrderId_ = bid.orderId_ },
+    };
+}
+
+/**
+ * @brief Checks an inbound message and turns it into the commands it stands for.
+ *
+ * Journal-only types, unknown enum values and commands that fail ValidateCommand, the
+ * check the book applies to the same command, are invalid.
+ * @param message The message.
+ * @param command Receives the command.
+ * @param second Receives the sell-side command of a mass cancel of both sides.
+ * @return Number of commands: 0 if the message is invalid, 2 for a mass cancel of both sides, otherwise 1.
+ */
+inline std::size_t Decode(const OrderMessage& message, Command& command, Command& second){
+    if (message.side_ > static_cast<std::uint8_t>(Side::Sell) &&
+        !(message.type_ == MessageType::MassCancel && message.side_ == BothSides))
+        return 0;
+
+    switch (message.type_){
+        case MessageType::NewOrder:
+            if (message.orderType_ >= OrderTypeCount)
+                return 0;
+            // A display quantity too wide for Quantity would be cut short by ToCommand
+            if (static_cast<OrderType>(message.orderType_) == OrderType::Iceberg && message.expiry_ > message.quantity_)
+                return 0;
+            break;
+        case MessageType::ModifyOrder:
+        case MessageType::CancelOrder:
+            break;
+        case MessageType::MassCancel:
+            command = Command::MassCancel(Side::Buy);
+            second = Command::MassCancel(Side::Sell);
+            if (message.side_ == BothSides)
+                return 2;
+            if (message.side_ == static_cast<std::uint8_t>(Side::Sell))
+                command = second;
+            return 1;
+        default:
+            return 0;
+    }
+    command = message.ToCommand();
+    return ValidateCommand(command) == CommandStatus::Accepted ? 1 : 0;
+}
+
+/**
+ * @brief Decodes a buffer of inbound messages and applies them to a book, reporting each outcome.
+ *
+ * Messages are copied out of the buffer one at a time, so it needs no particular
+ * alignment, and nothing is allocated. Executions are reported by the book's listener
+ * (see ExecutionReporter) while a command is applied, so they precede its ack.
+ * @param input Received bytes.
+ * @param book Book with a public ProcessCommand(const Command&).
+ * @param output Called as output(const ReportMessage&) with an ack or reject per message.
+ * @return Bytes consumed: every complete message. The caller keeps the rest for the next call.
+ */
+template <typename Book, typename Output>
+std::size_t DispatchMessages(std::span<const std::byte> input, Book& book, Output&& output){
+    const auto count = input.size() / sizeof(OrderMessage);
+    for (std::size_t index = 0; index < count; ++index){
+        OrderMessage message;
+        std::memcpy(&message, input.data() + index * sizeof(OrderMessage), sizeof(message));
+
+        Command commands[2];
+        const auto decoded = Decode(message, commands[0], commands[1]);
+        if (decoded == 0){
+            output(EncodeReject(message.orderId_, CommandStatus::InvalidMessage));
+            continue;
+        }
+
+        auto status = CommandStatus::Accepted;
+        for (std::size_t command = 0; command < decoded; ++command)
+            if (const auto result = book.ProcessCommand(commands[command]); result != CommandStatus::Accepted)
+                status = result;
+        output(status == CommandStatus::Accepted ? EncodeAck(message.orderId_) : EncodeReject(message.orderId_, status));
+    }
+    return count * sizeof(OrderMessage);
+}
+
+/**
+ * @class ExecutionReporter
+ * @brief Book listener that encodes every trade as two execution messages.
+ * @tparam Output Called as output(const ReportMessage&).
+ */
+template <typename Output>
+class ExecutionReporter : public BookListener{
+public:
+    ExecutionReporter() = default;
+    explicit ExecutionReporter(Output output) : output_{ std::move(output) } { }
+
+    void OnTrade(const Trade& trade){
+        const auto [bid, ask] = EncodeExecutions(trade);
+        output_(bid);
+        output_(ask);
+    }
+
+    Output& GetOutput() { return output_; }
+
+private:
+    Output output_;
+};
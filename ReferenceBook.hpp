@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "Using.hpp"
+#include "Side.hpp"
+#include "Command.hpp"
+#include "Trade.hpp"
+#include "LevelInfo.hpp"
+#include "ExpiryWheel.hpp"
+#include "SessionClock.hpp"
+
+/**
+ * @class ReferenceBook
+ * @brief Deliberately plain model of the book's matching rules, to check the optimised Orderbook against.
+ *
+ * Levels are ordered maps of FIFO queues and every lookup is a linear scan, so each rule reads the
+ * way it is specified: price-time priority, trades at the resting price, Market orders sweeping to
+ * the worst opposite price and resting there, Fill-And-Kill and Fill-Or-Kill admission, modifies
+ * that keep priority only on a quantity cut at the same price, and Iceberg orders that show one
+ * slice at a time and rejoin the back of their queue with the next. Good-For-Day and Good-Till-Date
+ * orders carry their expiry through modifies and leave when Expire moves the clock past it, as the
+ * book's ExpireOrders does; a Good-For-Day order given no expiry takes the next session close.
+ */
+class ReferenceBook{
+public:
+    ReferenceBook() : now_{ ExpiryWheel::ToTick(std::chrono::system_clock::now()) } { }
+
+    /**
+     * @brief Applies a command and appends the trades it caused.
+     * @param command The command.
+     * @param trades Receives the trades, bid and ask side as the book reports them.
+     * @return Whether the command was accepted, and why not.
+     */
+    CommandStatus Apply(const Command& command, Trades& trades){
+        if (const auto status = ValidateCommand(command); status != CommandStatus::Accepted)
+            return status;
+
+        switch (command.type_){
+            case CommandType::Add:
+                return Add(command, trades);
+            case CommandType::Modify:
+                return Modify(command, trades);
+            case CommandType::Cancel:
+                return Cancel(command.orderId_) ? CommandStatus::Accepted : CommandStatus::UnknownOrderId;
+            case CommandType::MassCancel:
+                while (!Empty(command.side_))
+                    Cancel(FrontOf(command.side_));
+                return CommandStatus::Accepted;
+        }
+        throw std::logic_error("Unsupported Command");
+    }
+
+    /**
+     * @brief Moves the clock forward and cancels every order whose expiry is at or before it.
+     * @param now Current time in ExpiryWheel ticks; a time not after the clock is ignored, as the book's wheel does.
+     * @return Number of orders cancelled.
+     */
+    std::size_t Expire(std::uint64_t now){
+        if (now <= now_)
+            return 0;
+        now_ = now;
+
+        std::vector<OrderId> due;
+        auto Collect = [&](const auto& levels){
+            for (const auto& [price, queue] : levels)
+                for (const auto& order : queue)
+                    if (order.expiry_ != 0 && order.expiry_ <= now)
+                        due.push_back(order.orderId_);
+        };
+        Collect(bids_);
+        Collect(asks_);
+        for (const auto orderId : due)
+            Cancel(orderId);
+        return due.size();
+    }
+
+    /**
+     * @brief Bid levels with their total shown quantity, best first.
+     */
+    LevelInfos GetBids() const { return InfosOf(bids_); }
+
+    /**
+     * @brief Ask levels with their total shown quantity, best first.
+     */
+    LevelInfos GetAsks() const { return InfosOf(asks_); }
+
+    /**
+     * @brief Number of resting orders.
+     */
+    std::size_t Size() const { return orders_.size(); }
+
+private:
+    struct Resting{
+        OrderId orderId_;
+        Quantity quantity_;    ///< Everything left, shown or not.
+        Quantity shown_;       ///< Part of quantity_ on display.
+        Quantity display_;     ///< Slice size of an Iceberg; zero shows everything.
+        std::uint64_t expiry_; ///< Expiry tick; zero never expires.
+    };
+
+    using Queue = std::deque<Resting>;
+
+    CommandStatus Add(Command command, Trades& trades){
+        if (orders_.contains(command.orderId_))
+            return CommandStatus::DuplicateOrderId;
+
+        const auto opposite = command.side_ == Side::Buy ? Side::Sell : Side::Buy;
+        std::uint64_t expiry{ };
+        switch (command.orderType_){
+            case OrderType::Market:
+                if (Empty(opposite))
+                    return CommandStatus::NoLiquidity;
+                command.price_ = WorstPrice(opposite);
+                break;
+            case OrderType::FillAndKill:
+                if (!CanMatch(command.side_, command.price_))
+                    return CommandStatus::NoLiquidity;
+                break;
+            case OrderType::FillOrKill:
+                if (!CanMatch(command.side_, command.price_) || Available(command.side_, command.price_) < command.quantity_)
+                    return CommandStatus::CannotFullyFill;
+                break;
+            case OrderType::GoodForDay:
+            case OrderType::GoodTillDate:
+                expiry = ExpiryOf(command);
+                if (expiry != 0 && expiry <= now_)
+                    return CommandStatus::AlreadyExpired;
+                break;
+            default:
+                break;
+        }
+
+        Match(command.orderId_, command.side_, command.price_, command.quantity_, trades);
+        const auto display = command.orderType_ == OrderType::Iceberg ? command.displayQuantity_ : Quantity{ };
+        if (command.quantity_ != 0 && command.orderType_ != OrderType::FillAndKill)
+            Rest(command.orderId_, command.side_, command.price_, command.quantity_, display, expiry);
+        return CommandStatus::Accepted;
+    }
+
+    CommandStatus Modify(const Command& command, Trades& trades){
+        const auto found = orders_.find(command.orderId_);
+        if (found == orders_.end())
+            return CommandStatus::UnknownOrderId;
+
+        const auto [side, price] = found->second;
+        auto& queue = QueueOf(side, price);
+        const auto resting = std::find_if(queue.begin(), queue.end(), [&](const Resting& order){ return order.orderId_ == command.orderId_; });
+
+        if (command.side_ == side && command.price_ == price && command.quantity_ <= resting->quantity_){
+            resting->quantity_ = command.quantity_;
+            resting->shown_ = std::min(resting->shown_, command.quantity_);
+            return CommandStatus::Accepted;
+        }
+
+        const auto display = resting->display_;
+        const auto expiry = resting->expiry_;
+        Cancel(command.orderId_);
+        auto quantity = command.quantity_;
+        if (command.side_ != side || command.price_ != price)
+            Match(command.orderId_, command.side_, command.price_, quantity, trades);
+        if (quantity != 0)
+            Rest(command.orderId_, command.side_, command.price_, quantity, display, expiry);
+        return CommandStatus::Accepted;
+    }
+
+    // Trade an incoming order against the opposite side, best price first, oldest order first
+    void Match(OrderId orderId, Side side, Price price, Quantity& quantity, Trades& trades){
+        auto Sweep = [&](auto& levels){
+            while (quantity != 0 && !levels.empty()){
+                auto& [levelPrice, queue] = *levels.begin();
+                if (side == Side::Buy ? price < levelPrice : price > levelPrice)
+                    return;
+
+                // Only the shown part trades; an Iceberg then goes to the back with its next slice
+                auto& resting = queue.front();
+                const auto traded = std::min(quantity, resting.shown_);
+                quantity -= traded;
+                resting.quantity_ -= traded;
+                resting.shown_ -= traded;
+
+                const TradeInfo incoming{ orderId, price, traded };
+                const TradeInfo matched{ resting.orderId_, levelPrice, traded };
+                trades.push_back(side == Side::Buy ? Trade{ incoming, matched } : Trade{ matched, incoming });
+
+                if (resting.quantity_ == 0){
+                    orders_.erase(resting.orderId_);
+                    queue.pop_front();
+                }else if (resting.shown_ == 0){
+                    auto replenished = resting;
+                    replenished.shown_ = SliceOf(replenished.quantity_, replenished.display_);
+                    queue.pop_front();
+                    queue.push_back(replenished);
+                }
+                if (queue.empty())
+                    levels.erase(levels.begin());
+            }
+        };
+
+        if (side == Side::Buy)
+            Sweep(asks_);
+        else
+            Sweep(bids_);
+    }
+
+    void Rest(OrderId orderId, Side side, Price price, Quantity quantity, Quantity display, std::uint64_t expiry){
+        QueueOf(side, price).push_back(Resting{ orderId, quantity, SliceOf(quantity, display), display, expiry });
+        orders_.emplace(orderId, std::pair{ side, price });
+    }
+
+    // A Good-For-Day order without an expiry of its own lasts until the next session close
+    static std::uint64_t ExpiryOf(const Command& command){
+        if (command.orderType_ == OrderType::GoodTillDate || command.expiry_ != Timestamp{ })
+            return ExpiryWheel::ToTick(command.expiry_);
+        const auto close = NextSessionClose(std::chrono::system_clock::now());
+        return close ? ExpiryWheel::ToTick(*close) : 0;
+    }
+
+    static Quantity SliceOf(Quantity quantity, Quantity display) { return display == 0 ? quantity : std::min(quantity, display); }
+
+    bool Cancel(OrderId orderId){
+        const auto found = orders_.find(orderId);
+        if (found == orders_.end())
+            return false;
+
+        const auto [side, price] = found->second;
+        orders_.erase(found);
+
+        auto& queue = QueueOf(side, price);
+        std::erase_if(queue, [orderId](const Resting& order){ return order.orderId_ == orderId; });
+        if (queue.empty()){
+            if (side == Side::Buy)
+                bids_.erase(price);
+            else
+                asks_.erase(price);
+        }
+        return true;
+    }
+
+    // Whether an order of side at price crosses the opposite best
+    bool CanMatch(Side side, Price price) const{
+        if (side == Side::Buy)
+            return !asks_.empty() && price >= asks_.begin()->first;
+        return !bids_.empty() && price <= bids_.begin()->first;
+    }
+
+    // Opposite quantity an order of side at price could trade with
+    std::uint64_t Available(Side side, Price price) const{
+        auto Sum = [&](const auto& levels){
+            std::uint64_t quantity{ };
+            for (const auto& [levelPrice, queue] : levels){
+                if (side == Side::Buy ? price < levelPrice : price > levelPrice)
+                    break;
+                for (const auto& order : queue)
+                    quantity += order.quantity_;
+            }
+            return quantity;
+        };
+        return side == Side::Buy ? Sum(asks_) : Sum(bids_);
+    }
+
+    Queue& QueueOf(Side side, Price price) { return side == Side::Buy ? bids_[price] : asks_[price]; }
+    bool Empty(Side side) const { return side == Side::Buy ? bids_.empty() : asks_.empty(); }
+    OrderId FrontOf(Side side) const { return side == Side::Buy ? bids_.begin()->second.front().orderId_ : asks_.begin()->second.front().orderId_; }
+    Price WorstPrice(Side side) const { return side == Side::Buy ? bids_.rbegin()->first : asks_.rbegin()->first; }
+
+    template <typename Levels>
+    static LevelInfos InfosOf(const Levels& levels){
+        LevelInfos infos;
+        for (const auto& [price, queue] : levels){
+            Quantity quantity{ };
+            for (const auto& order : queue)
+                quantity += order.shown_;
+            infos.push_back(LevelInfo{ price, quantity });
+        }
+        return infos;
+    }
+
+    std::map<Price, Queue, std::greater<Price>> bids_;
+    std::map<Price, Queue, std::less<Price>> asks_;
+    std::unordered_map<OrderId, std::pair<Side, Price>> orders_;
+    std::uint64_t now_;
+};
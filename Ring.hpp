@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ThreadAffinity.hpp"
+#include "HugePageArena.hpp"
+
+/**
+ * @brief Size of the cache line that ring cursors are padded to.
+ */
+inline constexpr std::size_t CacheLineSize = 64;
+
+/**
+ * @class MpscRing
+ * @brief Bounded, pre-allocated multi-producer / single-consumer queue.
+ *
+ * Each cell carries a sequence number: producers claim a position with one CAS on the
+ * tail and publish by storing position + 1 into the cell, the consumer frees a cell by
+ * storing position + capacity. No locks and no allocation after construction.
+ *
+ * @tparam T Trivially copyable element type.
+ */
+template <typename T>
+class MpscRing{
+public:
+    /**
+     * @param capacity Minimum number of elements; rounded up to a power of two.
+     * @param arena Arena to take the cells from; the heap if null.
+     */
+    explicit MpscRing(std::size_t capacity, HugePageArena* arena = nullptr)
+        : capacity_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) }
+        , mask_{ capacity_ - 1 }
+        , cells_(capacity_, ArenaAllocator<Cell>{ arena })
+    {
+        for (std::size_t i = 0; i < capacity_; ++i)
+            cells_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Publishes an element if there is room. Safe to call from any thread.
+     * @param value Element to publish.
+     * @param sequence Receives the position the element was published at.
+     * @return False if the ring is full.
+     */
+    bool TryPublish(const T& value, std::uint64_t& sequence){
+        auto position = tail_.load(std::memory_order_relaxed);
+        while (true){
+            auto& cell = cells_[position & mask_];
+            const auto cellSequence = cell.sequence_.load(std::memory_order_acquire);
+            const auto distance = static_cast<std::int64_t>(cellSequence - position);
+
+            if (distance == 0){
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    cell.value_ = value;
+                    cell.sequence_.store(position + 1, std::memory_order_release);
+                    sequence = position;
+                    return true;
+                }
+            }
+            else if (distance < 0)
+                return false;
+            else
+                position = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Publishes an element, waiting (spin, then yield) while the ring is full.
+     * @param value Element to publish.
+     * @return The position the element was published at.
+     */
+    std::uint64_t Publish(const T& value){
+        std::uint64_t sequence;
+        SpinBackoff backoff;
+        while (!TryPublish(value, sequence))
+            backoff.Pause();
+        return sequence;
+    }
+
+    /**
+     * @brief Takes the oldest element. Must only be called from the consumer thread.
+     * @param value Receives the element.
+     * @return False if the ring is empty.
+     */
+    bool TryConsume(T& value){
+        auto& cell = cells_[head_ & mask_];
+        if (cell.sequence_.load(std::memory_order_acquire) != head_ + 1)
+            return false;
+
+        value = cell.value_;
+        cell.sequence_.store(head_ + capacity_, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+    /**
+     * @brief Number of positions claimed by producers so far.
+     */
+    std::uint64_t Claimed() const { return tail_.load(std::memory_order_acquire); }
+
+private:
+    struct alignas(CacheLineSize) Cell{
+        std::atomic<std::uint64_t> sequence_{ };
+        T value_{ };
+    };
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    ArenaVector<Cell> cells_;
+    alignas(CacheLineSize) std::atomic<std::uint64_t> tail_{ };
+    alignas(CacheLineSize) std::uint64_t head_{ };
+};
+
+/**
+ * @class BroadcastRing
+ * @brief Bounded single-producer ring read in full by every one of a fixed set of consumers.
+ *
+ * Each consumer owns a cursor; the producer only overwrites a slot once the slowest
+ * consumer has moved past it, so every consumer sees every element in order.
+ *
+ * @tparam T Trivially copyable element type.
+ */
+template <typename T>
+class BroadcastRing{
+public:
+    /**
+     * @param capacity Minimum number of elements; rounded up to a power of two.
+     * @param consumers Number of consumers reading the ring.
+     * @param arena Arena to take the slots from; the heap if null.
+     */
+    BroadcastRing(std::size_t capacity, std::size_t consumers, HugePageArena* arena = nullptr)
+        : capacity_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) }
+        , mask_{ capacity_ - 1 }
+        , slots_(capacity_, ArenaAllocator<T>{ arena })
+        , cursors_(consumers)
+    { }
+
+    /**
+     * @brief Publishes an element, waiting while the slowest consumer is a full ring behind.
+     * Must only be called from the producer thread.
+     * @param value Element to publish.
+     */
+    void Publish(const T& value){
+        const auto position = published_.load(std::memory_order_relaxed);
+        SpinBackoff backoff;
+        while (position - gate_ >= capacity_){
+            gate_ = SlowestCursor(position);
+            if (position - gate_ >= capacity_)
+                backoff.Pause();
+        }
+
+        slots_[position & mask_] = value;
+        published_.store(position + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Reads the next element for a consumer. Must only be called from that consumer's thread.
+     * @param consumer Index of the consumer.
+     * @param value Receives the element.
+     * @return False if the consumer has read everything published.
+     */
+    bool TryRead(std::size_t consumer, T& value){
+        auto& cursor = cursors_[consumer].position_;
+        const auto position = cursor.load(std::memory_order_relaxed);
+        if (position == published_.load(std::memory_order_acquire))
+            return false;
+
+        value = slots_[position & mask_];
+        cursor.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Number of elements published so far.
+     */
+    std::uint64_t Published() const { return published_.load(std::memory_order_acquire); }
+
+private:
+    struct alignas(CacheLineSize) Cursor{
+        std::atomic<std::uint64_t> position_{ };
+    };
+
+    std::uint64_t SlowestCursor(std::uint64_t fallback) const{
+        auto slowest = fallback;
+        for (const auto& cursor : cursors_)
+            slowest = std::min(slowest, cursor.position_.load(std::memory_order_acquire));
+        return slowest;
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    ArenaVector<T> slots_;
+    std::vector<Cursor> cursors_;
+    alignas(CacheLineSize) std::atomic<std::uint64_t> published_{ };
+    std::uint64_t gate_{ };
+};
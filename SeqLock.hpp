@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "Ring.hpp"
+
+/**
+ * @class SeqLock
+ * @brief Single-writer value that any number of readers copy out without blocking the writer.
+ *
+ * The writer makes the sequence odd, stores the value and makes it even again. A reader
+ * copies the value between two reads of the sequence and retries if the sequence was odd or
+ * moved, so it always returns one consistent write. The value is held as relaxed atomic words,
+ * so the racing copy is well defined, on cache lines of its own so readers do not slow the
+ * writer's other data.
+ *
+ * @tparam T Trivially copyable value type.
+ */
+template <typename T>
+class alignas(CacheLineSize) SeqLock{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied word by word");
+
+public:
+    /**
+     * @brief Publishes a new value. Only one thread may store.
+     * @param value Value to publish.
+     */
+    void Store(const T& value){
+        std::array<std::uint64_t, WordCount> words{ };
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const auto sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t index = 0; index < WordCount; ++index)
+            words_[index].store(words[index], std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies out the latest value. Safe to call from any thread; spins only while a store is in flight.
+     */
+    T Load() const{
+        std::array<std::uint64_t, WordCount> words;
+        while (true){
+            const auto before = sequence_.load(std::memory_order_acquire);
+            if (before & 1){
+                CpuRelax();
+                continue;
+            }
+
+            for (std::size_t index = 0; index < WordCount; ++index)
+                words[index] = words_[index].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before)
+                break;
+        }
+
+        // Through bytes and bit_cast: T may have default member initializers, which memcpy into it warns about
+        std::array<std::byte, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), words.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+private:
+    static constexpr std::size_t WordCount = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> sequence_{ };
+    std::array<std::atomic<std::uint64_t>, WordCount> words_{ };
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <optional>
+
+/**
+ * @brief Next Good-For-Day cutoff (16:00 local time) strictly after the given instant.
+ * @param now Instant to start from.
+ * @return The cutoff, or std::nullopt if the local time conversion failed.
+ */
+inline std::optional<std::chrono::system_clock::time_point> NextSessionClose(std::chrono::system_clock::time_point now){
+    using namespace std::chrono;
+    const auto end = hours(16);
+
+    const auto now_c = system_clock::to_time_t(now);
+    std::tm now_parts;
+
+    // Convert system time to local time safely depending on the platform
+    #ifdef _WIN32
+    localtime_s(&now_parts, &now_c);
+    #else
+    localtime_r(&now_c, &now_parts);
+    #endif
+
+    // If current time is past market close, set to next day
+    if (now_parts.tm_hour >= end.count())
+        now_parts.tm_mday += 1;
+
+    now_parts.tm_hour = end.count();
+    now_parts.tm_min = 0;
+    now_parts.tm_sec = 0;
+
+    // Convert tm structure back to time_point
+    const auto next = mktime(&now_parts);
+    if (next == -1)
+        return std::nullopt;
+
+    return system_clock::from_time_t(next);
+}
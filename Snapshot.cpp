@@ -0,0 +1,191 @@
+#include "Snapshot.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Side.hpp"
+#include "OrderTypes.hpp"
+
+namespace{
+    [[noreturn]] void ThrowSystemError(const char* what){
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    [[noreturn]] void ThrowCorrupt(){
+        throw std::runtime_error("File is not a complete snapshot of this version.");
+    }
+}
+
+bool SnapshotFileWriter::Open(const std::filesystem::path& temporary){
+    fd_ = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return fd_ >= 0;
+}
+
+void SnapshotFileWriter::Drain(){
+    const char* data = buffer_;
+    auto remaining = used_;
+    while (remaining > 0 && !failed_){
+        const auto written = ::write(fd_, data, remaining);
+        if (written < 0){
+            failed_ = errno != EINTR;
+            continue;
+        }
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+    used_ = 0;
+}
+
+bool SnapshotFileWriter::Commit(const std::filesystem::path& temporary, const std::filesystem::path& path){
+    Drain();
+    const bool synced = !failed_ && ::fsync(fd_) == 0;
+    ::close(fd_);
+    return synced && ::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+SnapshotTask& SnapshotTask::operator=(SnapshotTask&& other) noexcept{
+    if (this != &other){
+        if (pid_ > 0)
+            Wait();
+        pid_ = other.pid_;
+        succeeded_ = other.succeeded_;
+        other.pid_ = 0;
+    }
+    return *this;
+}
+
+SnapshotTask::~SnapshotTask(){
+    if (pid_ > 0)
+        Wait();
+}
+
+bool SnapshotTask::Wait(){
+    if (pid_ <= 0)
+        return succeeded_;
+
+    int status{ };
+    while (::waitpid(pid_, &status, 0) < 0 && errno == EINTR) { }
+    succeeded_ = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    pid_ = 0;
+    return succeeded_;
+}
+
+int SnapshotTask::Fork(){
+    const auto pid = ::fork();
+    if (pid < 0)
+        ThrowSystemError("Cannot fork snapshot process");
+    return pid;
+}
+
+// Skip atexit handlers and destructors: they belong to the parent
+void SnapshotTask::Exit(bool succeeded){
+    ::_exit(succeeded ? 0 : 1);
+}
+
+SnapshotReader::SnapshotReader(const std::filesystem::path& path){
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        ThrowSystemError("Cannot open snapshot");
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0){
+        const auto error = errno;
+        ::close(fd);
+        errno = error;
+        ThrowSystemError("Cannot stat snapshot");
+    }
+
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ < sizeof(SnapshotHeader)){
+        ::close(fd);
+        ThrowCorrupt();
+    }
+
+    mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    const auto error = errno;
+    ::close(fd);
+    if (mapping_ == MAP_FAILED){
+        mapping_ = nullptr;
+        errno = error;
+        ThrowSystemError("Cannot map snapshot");
+    }
+
+    // Restore reads the whole file front to back
+    ::madvise(mapping_, size_, MADV_SEQUENTIAL);
+    ::madvise(mapping_, size_, MADV_WILLNEED);
+
+    try{
+        Validate();
+    }catch (...){
+        ::munmap(mapping_, size_);
+        throw;
+    }
+}
+
+SnapshotReader::~SnapshotReader(){
+    if (mapping_)
+        ::munmap(mapping_, size_);
+}
+
+// Checked once here so a restore never fails halfway through building a book
+void SnapshotReader::Validate(){
+    const auto& header = Header();
+    const SnapshotHeader expected;
+    if (std::memcmp(header.magic_, expected.magic_, sizeof(expected.magic_)) != 0 || header.version_ != expected.version_)
+        ThrowCorrupt();
+
+    const auto levelCount = header.bidLevels_ + header.askLevels_;
+    const auto available = size_ - sizeof(SnapshotHeader);
+    if (levelCount > available / sizeof(SnapshotLevel) ||
+        header.orders_ > available / sizeof(SnapshotOrder) ||
+        levelCount * sizeof(SnapshotLevel) + header.orders_ * sizeof(SnapshotOrder) != available)
+        ThrowCorrupt();
+
+    const auto base = static_cast<const char*>(mapping_) + sizeof(SnapshotHeader);
+    levels_ = { reinterpret_cast<const SnapshotLevel*>(base), levelCount };
+    orders_ = { reinterpret_cast<const SnapshotOrder*>(base + levelCount * sizeof(SnapshotLevel)), header.orders_ };
+
+    auto order = orders_.begin();
+    for (std::size_t index = 0; index < levels_.size(); ++index){
+        const auto& level = levels_[index];
+        const auto side = index < header.bidLevels_ ? Side::Buy : Side::Sell;
+        if (level.side_ != static_cast<std::uint8_t>(side) || level.count_ == 0)
+            ThrowCorrupt();
+
+        // Strictly best first within a side
+        if (index != 0 && index != header.bidLevels_){
+            const auto previous = levels_[index - 1].price_;
+            if (side == Side::Buy ? level.price_ >= previous : level.price_ <= previous)
+                ThrowCorrupt();
+        }
+
+        if (static_cast<std::size_t>(orders_.end() - order) < level.count_)
+            ThrowCorrupt();
+
+        std::uint64_t quantity{ };
+        for (const auto end = order + level.count_; order != end; ++order){
+            if (order->side_ != level.side_ || order->price_ != level.price_ || order->orderType_ >= OrderTypeCount ||
+                order->remainingQuantity_ == 0 || order->remainingQuantity_ > order->initialQuantity_)
+                ThrowCorrupt();
+
+            // Only an Iceberg order keeps quantity out of sight, and never more than a slice in it
+            const bool iceberg = static_cast<OrderType>(order->orderType_) == OrderType::Iceberg;
+            if (iceberg ? order->shownQuantity_ == 0 || order->shownQuantity_ > std::min(order->displayQuantity_, order->remainingQuantity_)
+                        : order->shownQuantity_ != order->remainingQuantity_)
+                ThrowCorrupt();
+            quantity += order->shownQuantity_;
+        }
+        if (quantity != level.quantity_)
+            ThrowCorrupt();
+    }
+    if (order != orders_.end())
+        ThrowCorrupt();
+}
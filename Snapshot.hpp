@@ -0,0 +1,209 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <type_traits>
+
+#include "Using.hpp"
+
+static_assert(std::endian::native == std::endian::little, "Snapshot records are written in host byte order, which must be little-endian.");
+
+/**
+ * @struct SnapshotHeader
+ * @brief First block of a snapshot file: what follows and where the journal tail starts.
+ *
+ * The header is followed by bidLevels_ + askLevels_ SnapshotLevel records, bids then asks,
+ * each side best first, then by the orders_ SnapshotOrder records of those levels in the same
+ * order, each level's queue in priority order.
+ */
+struct SnapshotHeader{
+    char magic_[8]{ 'O', 'B', 'S', 'N', 'A', 'P', 'S', 'H' };
+    std::uint32_t version_{ 2 };
+    std::uint32_t reserved_{ };
+    std::uint64_t journalPosition_{ }; ///< Journal records already reflected in the snapshot.
+    std::uint64_t bidLevels_{ };
+    std::uint64_t askLevels_{ };
+    std::uint64_t orders_{ };
+    std::uint64_t padding_[2]{ };
+};
+
+/**
+ * @struct SnapshotLevel
+ * @brief One price level and its aggregates, which count only the shown part of Iceberg orders.
+ */
+struct SnapshotLevel{
+    Price price_{ };
+    Quantity quantity_{ };
+    Quantity count_{ };
+    std::uint8_t side_{ };
+    std::uint8_t reserved_[3]{ };
+};
+
+/**
+ * @struct SnapshotOrder
+ * @brief One resting order.
+ */
+struct SnapshotOrder{
+    OrderId orderId_{ };
+    std::uint64_t expiryTick_{ }; ///< Expiry wheel tick the order is scheduled at, 0 if none.
+    Price price_{ };
+    Quantity initialQuantity_{ };
+    Quantity remainingQuantity_{ };
+    std::uint8_t orderType_{ };
+    std::uint8_t side_{ };
+    std::uint8_t reserved_[2]{ };
+    Quantity displayQuantity_{ };  ///< Slice size of an Iceberg order, 0 for other types.
+    Quantity shownQuantity_{ };    ///< Part of remainingQuantity_ counted in the level's quantity_.
+};
+
+static_assert(sizeof(SnapshotHeader) == 64 && std::is_trivially_copyable_v<SnapshotHeader>);
+static_assert(sizeof(SnapshotLevel) == 16 && std::is_trivially_copyable_v<SnapshotLevel>);
+static_assert(sizeof(SnapshotOrder) == 40 && std::is_trivially_copyable_v<SnapshotOrder>);
+
+/**
+ * @class SnapshotFileWriter
+ * @brief Buffered record writer for the snapshot process.
+ *
+ * Runs in a forked child of a multithreaded process, where only async-signal-safe calls are
+ * allowed: it never allocates and only uses open, write, fsync and rename.
+ */
+class SnapshotFileWriter{
+public:
+    /**
+     * @brief Creates the temporary file. Returns false on failure.
+     * @param temporary File written until Commit renames it.
+     */
+    bool Open(const std::filesystem::path& temporary);
+
+    /**
+     * @brief Buffers one record.
+     * @param record The record.
+     */
+    template <typename Record>
+    void Write(const Record& record){
+        if (used_ + sizeof(Record) > sizeof(buffer_))
+            Drain();
+        std::memcpy(buffer_ + used_, &record, sizeof(Record));
+        used_ += sizeof(Record);
+    }
+
+    /**
+     * @brief Writes out the buffer, syncs the file and renames it into place.
+     * @param temporary File given to Open.
+     * @param path Final snapshot file.
+     * @return Whether every step succeeded.
+     */
+    bool Commit(const std::filesystem::path& temporary, const std::filesystem::path& path);
+
+private:
+    void Drain();
+
+    int fd_{ -1 };
+    bool failed_{ };
+    std::size_t used_{ };
+    alignas(64) char buffer_[1 << 16];
+};
+
+/**
+ * @class SnapshotTask
+ * @brief A snapshot being written by a forked copy of the process.
+ *
+ * fork() gives the child a copy-on-write image of the book as it was when the task started,
+ * so the book is only paused for the fork itself while the child serializes and writes it.
+ */
+class SnapshotTask{
+public:
+    SnapshotTask() = default;
+    SnapshotTask(const SnapshotTask&) = delete;
+    void operator=(const SnapshotTask&) = delete;
+    SnapshotTask(SnapshotTask&& other) noexcept : pid_{ other.pid_ }, succeeded_{ other.succeeded_ } { other.pid_ = 0; }
+    SnapshotTask& operator=(SnapshotTask&& other) noexcept;
+
+    /**
+     * @brief Waits for the snapshot if it is still being written.
+     */
+    ~SnapshotTask();
+
+    /**
+     * @brief Forks a child that writes a snapshot and exits.
+     * @param path Snapshot file; replaced atomically once complete.
+     * @param write Called in the child as write(writer) to emit the records.
+     * @throws std::system_error if the process cannot fork.
+     */
+    template <typename Writer>
+    static SnapshotTask Start(const std::filesystem::path& path, Writer&& write){
+        auto temporary = path;
+        temporary += ".tmp";
+
+        const auto pid = Fork();
+        if (pid == 0){
+            SnapshotFileWriter writer;
+            const bool opened = writer.Open(temporary);
+            if (opened)
+                write(writer);
+            Exit(opened && writer.Commit(temporary, path));
+        }
+        return SnapshotTask{ pid };
+    }
+
+    /**
+     * @brief Waits for the child to finish.
+     * @return Whether the snapshot file was written completely.
+     */
+    bool Wait();
+
+private:
+    explicit SnapshotTask(int pid) : pid_{ pid } { }
+
+    static int Fork();
+    [[noreturn]] static void Exit(bool succeeded);
+
+    int pid_{ };
+    bool succeeded_{ };
+};
+
+/**
+ * @class SnapshotReader
+ * @brief Read-only mapping of a snapshot file, validated and exposed in place.
+ */
+class SnapshotReader{
+public:
+    /**
+     * @param path Snapshot file.
+     * @throws std::system_error if the file cannot be opened or mapped.
+     * @throws std::runtime_error if the file is not a complete, consistent snapshot.
+     */
+    explicit SnapshotReader(const std::filesystem::path& path);
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    void operator=(const SnapshotReader&) = delete;
+    SnapshotReader(SnapshotReader&&) = delete;
+    void operator=(SnapshotReader&&) = delete;
+    ~SnapshotReader();
+
+    /**
+     * @brief Counts of the sections and the journal position of the snapshot.
+     */
+    const SnapshotHeader& Header() const { return *static_cast<const SnapshotHeader*>(mapping_); }
+
+    /**
+     * @brief Every level, bids then asks, each side best first.
+     */
+    std::span<const SnapshotLevel> Levels() const { return levels_; }
+
+    /**
+     * @brief Every order, level by level in the order of Levels(), each queue in priority order.
+     */
+    std::span<const SnapshotOrder> Orders() const { return orders_; }
+
+private:
+    void Validate();
+
+    void* mapping_{ };
+    std::size_t size_{ };
+    std::span<const SnapshotLevel> levels_;
+    std::span<const SnapshotOrder> orders_;
+};
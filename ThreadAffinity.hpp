@@ -0,0 +1,79 @@
+#pragma once
+
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Pins the calling thread to one CPU core.
+ * @param core Zero-based core number; a negative value leaves the thread unpinned.
+ * @return True if the thread is now pinned; false if pinning is unsupported or failed.
+ */
+inline bool PinCurrentThread(int core){
+    if (core < 0)
+        return false;
+
+    #if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+    #else
+    return false;
+    #endif
+}
+
+/**
+ * @brief Hint to the CPU that the caller is spinning on shared memory.
+ */
+inline void CpuRelax(){
+    #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    _mm_pause();
+    #elif defined(__aarch64__)
+    asm volatile("yield");
+    #else
+    std::this_thread::yield();
+    #endif
+}
+
+/**
+ * @enum IdleStrategy
+ * @brief How a thread polling a ring waits while it has nothing to do.
+ */
+enum class IdleStrategy{
+    Backoff,  ///< Spin for a while, then yield the core to other threads.
+    BusyPoll, ///< Spin without ever yielding; lowest wake-up latency, for a thread that owns its core.
+};
+
+/**
+ * @class SpinBackoff
+ * @brief Spins with CpuRelax for a while, then yields, so waiters cannot starve the thread they wait on.
+ *
+ * Under IdleStrategy::BusyPoll it keeps spinning instead.
+ */
+class SpinBackoff{
+public:
+    explicit SpinBackoff(IdleStrategy strategy = IdleStrategy::Backoff) : busyPoll_{ strategy == IdleStrategy::BusyPoll } { }
+
+    void Pause(){
+        if (busyPoll_ || spins_ < SpinLimit){
+            ++spins_;
+            CpuRelax();
+        }else
+            std::this_thread::yield();
+    }
+
+    void Reset() { spins_ = 0; }
+
+private:
+    static constexpr unsigned SpinLimit = 1'000;
+    unsigned spins_{ };
+    bool busyPoll_;
+};
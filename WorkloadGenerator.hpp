@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Using.hpp"
+#include "Protocol.hpp"
+
+/**
+ * @struct WorkloadConfig
+ * @brief Shape of the synthetic order flow produced by a WorkloadGenerator.
+ */
+struct WorkloadConfig{
+    std::uint64_t seed_{ 1 };             ///< Same seed, same workload (with the same standard library).
+    double arrivalRate_{ 1'000'000 };     ///< Mean messages per second; arrivals are Poisson.
+    double cancelRatio_{ 0.4 };           ///< Share of messages that cancel a live order.
+    double modifyRatio_{ 0.1 };           ///< Share of messages that modify a live order.
+    double marketRatio_{ 0.01 };          ///< Share of new orders that are Market orders.
+    double fillAndKillRatio_{ 0.05 };     ///< Share of new orders that are Fill-And-Kill.
+    double fillOrKillRatio_{ 0.02 };      ///< Share of new orders that are Fill-Or-Kill.
+    double crossRatio_{ 0.05 };           ///< Share of resting limit orders placed through the touch.
+    Price midPrice_{ 10'000 };            ///< Initial mid price.
+    Price maxDistance_{ 500 };            ///< Furthest a limit order is placed from the touch, in ticks.
+    double distanceExponent_{ 1.6 };      ///< Power-law exponent of the distance from the touch; larger is tighter.
+    double driftProbability_{ 0.001 };    ///< Chance per message that the mid moves by one tick.
+    Quantity meanQuantity_{ 100 };        ///< Mean order quantity; quantities are geometric.
+};
+
+/**
+ * @class WorkloadGenerator
+ * @brief Reproducible synthetic order flow as protocol messages.
+ *
+ * New orders are placed at a power-law distance from a drifting mid, so most liquidity sits
+ * near the touch with a long tail behind it; a few cross it. Aggressive orders (Market,
+ * Fill-And-Kill, Fill-Or-Kill) are priced through the touch. Cancels and modifies pick a
+ * random order the generator placed and has not cancelled yet; it does not run a book, so
+ * some of them target orders that have already traded, as late cancels do in real flow.
+ * Each message carries the Poisson inter-arrival gap in delay_.
+ */
+class WorkloadGenerator{
+public:
+    explicit WorkloadGenerator(const WorkloadConfig& config = { })
+        : config_{ config }
+        , random_{ config.seed_ }
+        , arrival_{ config.arrivalRate_ / 1e6 }
+        , quantity_{ 1.0 / std::max<double>(config.meanQuantity_, 1.0) }
+        , mid_{ config.midPrice_ }
+    { }
+
+    /**
+     * @brief The next message of the workload.
+     */
+    OrderMessage Next(){
+        OrderMessage message;
+        message.delay_ = static_cast<std::uint32_t>(std::min(arrival_(random_), 4e9));
+
+        if (Chance(config_.driftProbability_))
+            mid_ = std::max<Price>(mid_ + (Chance(0.5) ? 1 : -1), config_.maxDistance_ + 2);
+
+        const auto pick = unit_(random_);
+        if (!live_.empty() && pick < config_.cancelRatio_ + config_.modifyRatio_){
+            // Swap-remove a random live order
+            const auto index = std::uniform_int_distribution<std::size_t>{ 0, live_.size() - 1 }(random_);
+            const auto orderId = live_[index];
+
+            if (pick < config_.cancelRatio_){
+                live_[index] = live_.back();
+                live_.pop_back();
+                message.type_ = MessageType::CancelOrder;
+                message.orderId_ = orderId;
+                return message;
+            }
+
+            const auto side = Chance(0.5) ? Side::Buy : Side::Sell;
+            message.type_ = MessageType::ModifyOrder;
+            message.orderId_ = orderId;
+            message.side_ = static_cast<std::uint8_t>(side);
+            message.price_ = PassivePrice(side);
+            message.quantity_ = NextQuantity();
+            return message;
+        }
+
+        const auto side = Chance(0.5) ? Side::Buy : Side::Sell;
+        const auto type = unit_(random_);
+        auto orderType = OrderType::GoodTillCancel;
+        if (type < config_.marketRatio_)
+            orderType = OrderType::Market;
+        else if (type < config_.marketRatio_ + config_.fillAndKillRatio_)
+            orderType = OrderType::FillAndKill;
+        else if (type < config_.marketRatio_ + config_.fillAndKillRatio_ + config_.fillOrKillRatio_)
+            orderType = OrderType::FillOrKill;
+
+        message.type_ = MessageType::NewOrder;
+        message.orderType_ = static_cast<std::uint8_t>(orderType);
+        message.orderId_ = ++lastOrderId_;
+        message.side_ = static_cast<std::uint8_t>(side);
+        message.quantity_ = NextQuantity();
+
+        if (orderType == OrderType::Market)
+            message.price_ = 0;
+        else if (orderType != OrderType::GoodTillCancel || Chance(config_.crossRatio_))
+            message.price_ = AggressivePrice(side);
+        else
+            message.price_ = PassivePrice(side);
+
+        if (orderType == OrderType::GoodTillCancel)
+            live_.push_back(message.orderId_);
+        return message;
+    }
+
+private:
+    bool Chance(double probability) { return unit_(random_) < probability; }
+
+    // Pareto-distributed ticks behind the touch, capped at maxDistance_
+    Price Distance(){
+        const auto exponent = std::max(config_.distanceExponent_ - 1.0, 0.05);
+        const auto distance = std::pow(1.0 - unit_(random_), -1.0 / exponent) - 1.0;
+        return static_cast<Price>(std::min<double>(distance, config_.maxDistance_));
+    }
+
+    Price PassivePrice(Side side) { return side == Side::Buy ? mid_ - 1 - Distance() : mid_ + 1 + Distance(); }
+
+    Price AggressivePrice(Side side){
+        const auto through = Distance() % 5;
+        return side == Side::Buy ? mid_ + 1 + through : mid_ - 1 - through;
+    }
+
+    Quantity NextQuantity() { return quantity_(random_) + 1; }
+
+    WorkloadConfig config_;
+    std::mt19937_64 random_;
+    std::uniform_real_distribution<double> unit_{ 0.0, 1.0 };
+    std::exponential_distribution<double> arrival_;   ///< Gap to the next message in microseconds.
+    std::geometric_distribution<Quantity> quantity_;
+    Price mid_;
+    OrderId lastOrderId_{ };
+    std::vector<OrderId> live_;
+};
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "Orderbook.hpp"
+#include "WorkloadGenerator.hpp"
+
+namespace {
+    using Book = BasicOrderbook<BookListener>;
+
+    constexpr Price BidTouch = 10'000;
+    constexpr Price AskTouch = 10'001;
+
+    std::unique_ptr<Book> MakeBook() {
+        return std::make_unique<Book>(OrderbookConfig{
+            .basePrice_ = 0, .levelCount_ = 1 << 15, .orderCapacity_ = 1 << 20, .startPruneThread_ = false});
+    }
+
+    // Rests depth levels of perLevel orders on one side, best level first; returns the ids in that order
+    std::deque<OrderId> Populate(Book& book, Side side, std::size_t depth, std::size_t perLevel, OrderId& nextId) {
+        std::deque<OrderId> ids;
+        for (std::size_t level = 0; level < depth; ++level) {
+            const auto price = side == Side::Buy ? BidTouch - static_cast<Price>(level) : AskTouch + static_cast<Price>(level);
+            for (std::size_t index = 0; index < perLevel; ++index) {
+                book.AddOrder(Order{OrderType::GoodTillCancel, nextId, side, price, 10});
+                ids.push_back(nextId++);
+            }
+        }
+        return ids;
+    }
+
+    // Steady-state passive flow: every add rests behind its level and is matched by a cancel of the oldest order
+    void BM_AddCancelPassive(benchmark::State& state) {
+        const auto depth = static_cast<std::size_t>(state.range(0));
+        const auto perLevel = static_cast<std::size_t>(state.range(1));
+        auto book = MakeBook();
+        OrderId nextId = 1;
+        auto ids = Populate(*book, Side::Buy, depth, perLevel, nextId);
+
+        std::size_t level = 0;
+        for (auto _ : state) {
+            const auto price = BidTouch - static_cast<Price>(level);
+            level = level + 1 == depth ? 0 : level + 1;
+            benchmark::DoNotOptimize(book->AddOrder(Order{OrderType::GoodTillCancel, nextId, Side::Buy, price, 10}));
+            ids.push_back(nextId++);
+            benchmark::DoNotOptimize(book->CancelOrder(ids.front()));
+            ids.pop_front();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * 2);
+    }
+    BENCHMARK(BM_AddCancelPassive)->ArgNames({"depth", "perLevel"})->ArgsProduct({{1, 64, 1024}, {1, 16, 256}});
+
+    // Cancels of random resting orders, as most of a real feed is
+    void BM_CancelRandom(benchmark::State& state) {
+        const auto depth = static_cast<std::size_t>(state.range(0));
+        const auto perLevel = static_cast<std::size_t>(state.range(1));
+        auto book = MakeBook();
+        OrderId nextId = 1;
+        const auto resting = Populate(*book, Side::Sell, depth, perLevel, nextId);
+        std::vector<OrderId> ids(resting.begin(), resting.end());
+        std::mt19937_64 random{1};
+
+        for (auto _ : state) {
+            // Swap-remove a random order and put a fresh one at the same price
+            const auto index = std::uniform_int_distribution<std::size_t>{0, ids.size() - 1}(random);
+            const auto price = AskTouch + static_cast<Price>(index / perLevel);
+            benchmark::DoNotOptimize(book->CancelOrder(ids[index]));
+            book->AddOrder(Order{OrderType::GoodTillCancel, nextId, Side::Sell, price, 10});
+            ids[index] = nextId++;
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * 2);
+    }
+    BENCHMARK(BM_CancelRandom)->ArgNames({"depth", "perLevel"})->ArgsProduct({{64, 1024}, {16, 256}});
+
+    // Modifies that move an order to another level of its side
+    void BM_ModifyAcrossLevels(benchmark::State& state) {
+        const auto depth = static_cast<std::size_t>(state.range(0));
+        auto book = MakeBook();
+        OrderId nextId = 1;
+        const auto resting = Populate(*book, Side::Buy, depth, 8, nextId);
+        std::vector<OrderId> ids(resting.begin(), resting.end());
+
+        std::size_t index = 0, level = 0;
+        for (auto _ : state) {
+            const auto price = BidTouch - static_cast<Price>(level);
+            level = (level + 7) % depth;
+            benchmark::DoNotOptimize(book->ModifyOrder(OrderModify{ids[index], Side::Buy, price, 10}));
+            index = index + 1 == ids.size() ? 0 : index + 1;
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+    }
+    BENCHMARK(BM_ModifyAcrossLevels)->ArgNames({"depth"})->Arg(16)->Arg(1024);
+
+    // One aggressive order sweeping every level of the opposite side; the refill is not timed
+    void BM_Sweep(benchmark::State& state) {
+        const auto levels = static_cast<std::size_t>(state.range(0));
+        const auto perLevel = static_cast<std::size_t>(state.range(1));
+        auto book = MakeBook();
+        OrderId nextId = 1;
+        const auto worst = AskTouch + static_cast<Price>(levels) - 1;
+        const auto quantity = static_cast<Quantity>(levels * perLevel * 10);
+
+        for (auto _ : state) {
+            state.PauseTiming();
+            Populate(*book, Side::Sell, levels, perLevel, nextId);
+            state.ResumeTiming();
+            benchmark::DoNotOptimize(book->AddOrder(Order{OrderType::FillAndKill, nextId++, Side::Buy, worst, quantity}));
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * levels * perLevel));
+    }
+    BENCHMARK(BM_Sweep)->ArgNames({"levels", "perLevel"})->ArgsProduct({{1, 16, 256}, {1, 16}});
+
+    // Walks one deep level as matching does, over the 24-byte queue entries alone (fullRecord 0), or
+    // reading every order's full record as well, as a layout without the hot/cold split must (fullRecord 1).
+    // The level links its slots in shuffled order, as churn leaves them, so neither walk is a linear scan.
+    void BM_DeepLevelWalk(benchmark::State& state) {
+        const auto orders = static_cast<std::size_t>(state.range(0));
+        const bool fullRecord = state.range(1) != 0;
+        OrderPool pool;
+        std::vector<OrderHandle> handles;
+        for (std::size_t index = 0; index < orders; ++index)
+            handles.push_back(pool.Acquire(Order{OrderType::GoodTillCancel, index + 1, Side::Sell, AskTouch, 10}));
+        std::shuffle(handles.begin(), handles.end(), std::mt19937_64{1});
+        OrderList level;
+        for (const auto handle : handles)
+            pool.PushBack(level, handle);
+
+        for (auto _ : state) {
+            std::uint64_t quantity = 0;
+            for (auto handle = level.head_; handle != InvalidOrderHandle;) {
+                const auto& queued = pool.Queued(handle);
+                quantity += fullRecord ? pool[handle].GetRemainingQuantity() : queued.remaining_;
+                handle = queued.next_;
+            }
+            benchmark::DoNotOptimize(quantity);
+        }
+        const auto bytesPerOrder = sizeof(QueuedOrder) + (fullRecord ? sizeof(PooledOrder) : 0);
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * orders));
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * orders * bytesPerOrder));
+    }
+    BENCHMARK(BM_DeepLevelWalk)->ArgNames({"orders", "fullRecord"})->ArgsProduct({{1 << 10, 1 << 16}, {0, 1}});
+
+    // Fill-Or-Kill orders one lot short of the liquidity they can reach, so every check walks all of it
+    void BM_FillOrKillMiss(benchmark::State& state) {
+        const auto depth = static_cast<std::size_t>(state.range(0));
+        auto book = MakeBook();
+        OrderId nextId = 1;
+        Populate(*book, Side::Sell, depth, 4, nextId);
+        const auto worst = AskTouch + static_cast<Price>(depth) - 1;
+        const auto quantity = static_cast<Quantity>(depth * 4 * 10 + 1);
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(book->AddOrder(Order{OrderType::FillOrKill, nextId++, Side::Buy, worst, quantity}));
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+    }
+    BENCHMARK(BM_FillOrKillMiss)->ArgNames({"depth"})->Arg(1)->Arg(16)->Arg(256);
+
+    // A default book, with no price grid, taking every order at a price it has not seen; each add
+    // is matched by a cancel of the oldest, so the number of live prices stays at the argument
+    void BM_DistinctPrices(benchmark::State& state) {
+        const auto resting = static_cast<std::size_t>(state.range(0));
+        Book book{OrderbookConfig{.startPruneThread_ = false}};
+        std::mt19937_64 random{1};
+        std::deque<OrderId> ids;
+        OrderId nextId = 1;
+        auto AddAtNewPrice = [&] {
+            // Bids spread below the touch, so nothing crosses and every price lands inside the held range
+            const auto price = BidTouch - static_cast<Price>(random() % (1u << 30)) - 1;
+            benchmark::DoNotOptimize(book.AddOrder(Order{OrderType::GoodTillCancel, nextId, Side::Buy, price, 10}));
+            ids.push_back(nextId++);
+        };
+        while (ids.size() < resting)
+            AddAtNewPrice();
+
+        for (auto _ : state) {
+            AddAtNewPrice();
+            benchmark::DoNotOptimize(book.CancelOrder(ids.front()));
+            ids.pop_front();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * 2);
+    }
+    BENCHMARK(BM_DistinctPrices)->ArgNames({"resting"})->Arg(1024)->Arg(1 << 16);
+
+    // Full depth snapshot of both sides
+    void BM_GetOrderInfos(benchmark::State& state) {
+        const auto depth = static_cast<std::size_t>(state.range(0));
+        auto book = MakeBook();
+        OrderId nextId = 1;
+        Populate(*book, Side::Buy, depth, 4, nextId);
+        Populate(*book, Side::Sell, depth, 4, nextId);
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(book->GetOrderInfos());
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * depth * 2));
+    }
+    BENCHMARK(BM_GetOrderInfos)->ArgNames({"depth"})->Arg(16)->Arg(1024);
+
+    // Synthetic mixed flow; the cancel share is the argument, in percent
+    void BM_Workload(benchmark::State& state) {
+        WorkloadGenerator generator{WorkloadConfig{.cancelRatio_ = static_cast<double>(state.range(0)) / 100.0}};
+        std::vector<Command> commands;
+        for (std::size_t index = 0; index < (1 << 20); ++index) {
+            Command command, second;
+            if (Decode(generator.Next(), command, second) == 1)
+                commands.push_back(command);
+        }
+
+        auto book = MakeBook();
+        std::size_t next = 0;
+        for (auto _ : state) {
+            if (next == commands.size()) {
+                state.PauseTiming();
+                book = MakeBook();
+                next = 0;
+                state.ResumeTiming();
+            }
+            benchmark::DoNotOptimize(book->ProcessCommand(commands[next++]));
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+    }
+    BENCHMARK(BM_Workload)->ArgNames({"cancelPercent"})->Arg(40)->Arg(80);
+
+    /**
+     * @class CollectingReporter
+     * @brief Console reporter that also keeps the real time of every run, in nanoseconds.
+     */
+    class CollectingReporter : public benchmark::ConsoleReporter {
+    public:
+        explicit CollectingReporter(OutputOptions options) : ConsoleReporter{options} {}
+
+        void ReportRuns(const std::vector<Run>& runs) override {
+            ConsoleReporter::ReportRuns(runs);
+            for (const auto& run : runs)
+                if (!run.error_occurred)
+                    times_[run.benchmark_name()] = run.GetAdjustedRealTime() / benchmark::GetTimeUnitMultiplier(run.time_unit) * 1e9;
+        }
+
+        const std::map<std::string, double>& Times() const { return times_; }
+
+    private:
+        std::map<std::string, double> times_;
+    };
+
+    double NanosecondsPer(std::string_view unit) {
+        if (unit == "us") return 1e3;
+        if (unit == "ms") return 1e6;
+        if (unit == "s") return 1e9;
+        return 1.0;
+    }
+
+    // Real times by name from a --benchmark_out JSON file; just enough of a scanner for the benchmark library's own output
+    std::map<std::string, double> ReadBaseline(const std::string& path) {
+        std::ifstream file{path};
+        if (!file)
+            throw std::runtime_error("Cannot open baseline " + path);
+        const std::string text{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+        auto StringAfter = [&](std::size_t from, std::size_t to, std::string_view key) -> std::string {
+            const auto at = text.find(key, from);
+            if (at == std::string::npos || at > to)
+                return {};
+            const auto begin = text.find('"', at + key.size()) + 1;
+            return text.substr(begin, text.find('"', begin) - begin);
+        };
+
+        std::map<std::string, double> times;
+        auto position = text.find("\"benchmarks\"");
+        while (position != std::string::npos) {
+            const auto begin = text.find('{', position);
+            if (begin == std::string::npos)
+                break;
+            const auto end = text.find('}', begin);
+            const auto name = StringAfter(begin, end, "\"name\":");
+            const auto realTime = text.find("\"real_time\":", begin);
+            if (!name.empty() && realTime < end)
+                times[name] = std::strtod(text.c_str() + realTime + std::strlen("\"real_time\":"), nullptr) *
+                              NanosecondsPer(StringAfter(begin, end, "\"time_unit\":"));
+            position = end;
+        }
+        return times;
+    }
+
+    // Prints the change of every benchmark found in both runs; returns the number slower than the threshold allows
+    std::size_t Compare(const std::map<std::string, double>& baseline, const std::map<std::string, double>& current, double threshold) {
+        std::size_t regressions = 0;
+        std::cout << "\nComparison against baseline (threshold " << threshold << "%):\n";
+        for (const auto& [name, time] : current) {
+            const auto found = baseline.find(name);
+            if (found == baseline.end() || found->second <= 0) {
+                std::cout << "  " << name << ": not in baseline\n";
+                continue;
+            }
+            const auto change = (time - found->second) / found->second * 100.0;
+            const bool regressed = change > threshold;
+            regressions += regressed;
+            std::cout << "  " << name << ": " << found->second << " ns -> " << time << " ns ("
+                      << (change >= 0 ? "+" : "") << std::round(change * 10) / 10 << "%)" << (regressed ? "  REGRESSION" : "") << '\n';
+        }
+        return regressions;
+    }
+}
+
+int main(int argc, char** argv) {
+    // Take out our own flags before the benchmark library sees the command line
+    std::string baseline;
+    double threshold = 10.0;
+    std::vector<char*> arguments;
+    for (int index = 0; index < argc; ++index) {
+        const std::string_view argument{argv[index]};
+        if (argument.starts_with("--baseline="))
+            baseline = argument.substr(std::strlen("--baseline="));
+        else if (argument.starts_with("--threshold="))
+            threshold = std::stod(std::string{argument.substr(std::strlen("--threshold="))});
+        else
+            arguments.push_back(argv[index]);
+    }
+
+    int count = static_cast<int>(arguments.size());
+    benchmark::Initialize(&count, arguments.data());
+    if (benchmark::ReportUnrecognizedArguments(count, arguments.data())) {
+        std::cerr << "Our own flags: --baseline=<benchmark JSON> to compare against, --threshold=<percent> (default 10).\n";
+        return 1;
+    }
+
+    // Colour only on a terminal, so redirected output stays readable
+    CollectingReporter reporter{isatty(STDOUT_FILENO) ? benchmark::ConsoleReporter::OO_ColorTabular : benchmark::ConsoleReporter::OO_Tabular};
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    if (baseline.empty())
+        return 0;
+    try {
+        return Compare(ReadBaseline(baseline), reporter.Times(), threshold) == 0 ? 0 : 2;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
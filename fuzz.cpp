@@ -0,0 +1,180 @@
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "DifferentialFuzzer.hpp"
+#include "WorkloadGenerator.hpp"
+#include "Protocol.hpp"
+
+namespace {
+    /**
+     * @struct FuzzOptions
+     * @brief Command line of the differential fuzzer.
+     */
+    struct FuzzOptions {
+        FuzzConfig fuzz_;
+        std::uint64_t streams_{100};
+        std::size_t benchCommands_{1'000'000};  ///< Commands timed on each book; zero skips the comparison.
+        bool journal_{};                         ///< Also journal every stream, replay it into a fresh book and compare.
+    };
+
+    void PrintUsage() {
+        std::cerr << "Usage: orderbook-fuzz [options]\n"
+                     "  --seed <seed>            Seed of the first stream; stream i uses seed + i (default 1).\n"
+                     "  --streams <count>        Streams to check (default 100).\n"
+                     "  --commands <count>       Commands per stream (default 10000).\n"
+                     "  --range <ticks>          Furthest an order is placed from the mid (default 16).\n"
+                     "  --max-quantity <qty>     Largest order quantity (default 50).\n"
+                     "  --journal                Also journal each stream on the optimised book, replay the journal\n"
+                     "                           into a fresh book and compare the two.\n"
+                     "  --bench <commands>       Commands timed on each book, on a fuzz stream and on a synthetic\n"
+                     "                           workload; 0 skips the comparison (default 1000000).\n";
+    }
+
+    FuzzOptions ParseOptions(int argc, char** argv) {
+        FuzzOptions options;
+        auto& fuzz = options.fuzz_;
+        for (int index = 1; index < argc; ++index) {
+            const std::string_view argument{argv[index]};
+            auto Value = [&]() -> std::string {
+                if (++index >= argc)
+                    throw std::invalid_argument(std::string{argument} + " needs a value.");
+                return argv[index];
+            };
+
+            if (argument == "--seed")
+                fuzz.seed_ = std::stoull(Value());
+            else if (argument == "--streams")
+                options.streams_ = std::stoull(Value());
+            else if (argument == "--commands")
+                fuzz.commands_ = std::stoul(Value());
+            else if (argument == "--range")
+                fuzz.priceRange_ = std::stoi(Value());
+            else if (argument == "--max-quantity")
+                fuzz.maxQuantity_ = static_cast<Quantity>(std::stoul(Value()));
+            else if (argument == "--bench")
+                options.benchCommands_ = std::stoul(Value());
+            else if (argument == "--journal")
+                options.journal_ = true;
+            else
+                throw std::invalid_argument("Unexpected argument: " + std::string{argument});
+        }
+
+        if (fuzz.priceRange_ < 0 || fuzz.priceRange_ >= fuzz.midPrice_)
+            throw std::invalid_argument("The price range must be non-negative and below the mid price.");
+        if (fuzz.maxQuantity_ == 0)
+            throw std::invalid_argument("The maximum quantity must be positive.");
+        return options;
+    }
+
+    // Every stream runs against a map-only book and one whose ladder covers only the middle of the band
+    OrderbookConfig LadderConfig(const FuzzConfig& fuzz) {
+        return OrderbookConfig{.basePrice_ = fuzz.midPrice_ - fuzz.priceRange_ / 2, .tickSize_ = 1,
+            .levelCount_ = static_cast<std::size_t>(fuzz.priceRange_) + 1};
+    }
+
+    template <typename Apply>
+    double Throughput(const Commands& commands, Apply&& apply) {
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& command : commands)
+            apply(command);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(commands.size()) / elapsed.count();
+    }
+
+    Commands GenerateWorkloadCommands(std::size_t count, std::uint64_t seed) {
+        WorkloadGenerator generator{WorkloadConfig{.seed_ = seed}};
+        Commands commands;
+        commands.reserve(count);
+        while (commands.size() < count) {
+            Command command, second;
+            const auto decoded = Decode(generator.Next(), command, second);
+            if (decoded > 0)
+                commands.push_back(command);
+            if (decoded > 1)
+                commands.push_back(second);
+        }
+        return commands;
+    }
+
+    void CompareThroughput(const char* name, const Commands& commands) {
+        ReferenceBook reference;
+        Trades trades;
+        const auto referenceRate = Throughput(commands, [&](const Command& command) {
+            trades.clear();
+            reference.Apply(command, trades);
+        });
+
+        Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+        auto& collected = orderbook.GetListener().GetTrades();
+        const auto orderbookRate = Throughput(commands, [&](const Command& command) {
+            collected.clear();
+            orderbook.ProcessCommand(command);
+        });
+
+        std::cout << name << " (" << commands.size() << " commands, " << orderbook.Size() << " resting at the end):\n"
+                  << "  Reference: " << static_cast<std::uint64_t>(referenceRate) << " msgs/sec\n"
+                  << "  Orderbook: " << static_cast<std::uint64_t>(orderbookRate) << " msgs/sec\n"
+                  << "  Speedup: " << orderbookRate / referenceRate << "x\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    FuzzOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        PrintUsage();
+        return 1;
+    }
+
+    try {
+        const auto firstSeed = options.fuzz_.seed_;
+        for (std::uint64_t stream = 0; stream < options.streams_; ++stream) {
+            auto fuzz = options.fuzz_;
+            fuzz.seed_ = firstSeed + stream;
+            const auto commands = GenerateFuzzCommands(fuzz);
+
+            std::vector<std::pair<const char*, StreamCheck>> checks{{"", RunDifferential}};
+            if (options.journal_)
+                checks.emplace_back(", journal round trip", RunJournalRoundTrip);
+
+            for (const auto& [name, config] : {std::pair{"map", OrderbookConfig{}}, std::pair{"ladder", LadderConfig(fuzz)}}) {
+                for (const auto& [checkName, check] : checks) {
+                    const auto result = check(commands, config);
+                    if (result)
+                        continue;
+
+                    const auto shrunk = ShrinkDivergence(commands, config, check);
+                    std::cout << "Divergence with seed " << fuzz.seed_ << " (" << name << " book" << checkName << ") after command "
+                              << *result.failure_ << ": " << result.reason_ << '\n'
+                              << "Failing stream, reduced from that prefix to " << shrunk.size() << " commands ("
+                              << check(shrunk, config).reason_ << "):\n";
+                    for (const auto& command : shrunk)
+                        std::cout << "  " << Describe(command) << '\n';
+                    return 2;
+                }
+            }
+        }
+        std::cout << "Streams: " << options.streams_ << " x " << options.fuzz_.commands_ << " commands"
+                  << (options.journal_ ? ", journal round trips included" : "") << ", no divergence\n";
+
+        if (options.benchCommands_ != 0) {
+            // The fuzz streams keep the book shallow; the synthetic workload builds realistic depth
+            auto fuzz = options.fuzz_;
+            fuzz.commands_ = options.benchCommands_;
+            CompareThroughput("Fuzz stream", GenerateFuzzCommands(fuzz));
+            CompareThroughput("Workload", GenerateWorkloadCommands(options.benchCommands_, firstSeed));
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Journal.hpp"
+#include "WorkloadGenerator.hpp"
+
+namespace {
+    /**
+     * @struct GeneratorOptions
+     * @brief Command line of the workload generator.
+     */
+    struct GeneratorOptions {
+        std::filesystem::path output_;
+        std::uint64_t messages_{1'000'000};
+        bool binary_{true};
+        WorkloadConfig workload_;
+    };
+
+    void PrintUsage() {
+        std::cerr << "Usage: orderbook-generate <output file> [options]\n"
+                     "  --messages <count>     Messages to generate (default 1000000).\n"
+                     "  --format binary|text   Journal-format binary with arrival gaps (default), or text.\n"
+                     "  --seed <seed>          Random seed (default 1).\n"
+                     "  --rate <msgs/sec>      Mean Poisson arrival rate (default 1000000).\n"
+                     "  --cancel <ratio>       Share of cancels (default 0.4).\n"
+                     "  --modify <ratio>       Share of modifies (default 0.1).\n"
+                     "  --market <ratio>       Share of new orders that are Market (default 0.01).\n"
+                     "  --fak <ratio>          Share of new orders that are Fill-And-Kill (default 0.05).\n"
+                     "  --fok <ratio>          Share of new orders that are Fill-Or-Kill (default 0.02).\n"
+                     "  --cross <ratio>        Share of limit orders placed through the touch (default 0.05).\n"
+                     "  --mid <price>          Initial mid price (default 10000).\n"
+                     "  --max-distance <ticks> Furthest distance from the touch (default 500).\n"
+                     "  --exponent <alpha>     Power-law exponent of the distance from the touch (default 1.6).\n";
+    }
+
+    GeneratorOptions ParseOptions(int argc, char** argv) {
+        GeneratorOptions options;
+        auto& workload = options.workload_;
+        for (int index = 1; index < argc; ++index) {
+            const std::string_view argument{argv[index]};
+            auto Value = [&]() -> std::string {
+                if (++index >= argc)
+                    throw std::invalid_argument(std::string{argument} + " needs a value.");
+                return argv[index];
+            };
+
+            if (argument == "--messages")
+                options.messages_ = std::stoull(Value());
+            else if (argument == "--format") {
+                const auto format = Value();
+                if (format != "text" && format != "binary")
+                    throw std::invalid_argument("Unknown format: " + format);
+                options.binary_ = format == "binary";
+            }
+            else if (argument == "--seed")
+                workload.seed_ = std::stoull(Value());
+            else if (argument == "--rate")
+                workload.arrivalRate_ = std::stod(Value());
+            else if (argument == "--cancel")
+                workload.cancelRatio_ = std::stod(Value());
+            else if (argument == "--modify")
+                workload.modifyRatio_ = std::stod(Value());
+            else if (argument == "--market")
+                workload.marketRatio_ = std::stod(Value());
+            else if (argument == "--fak")
+                workload.fillAndKillRatio_ = std::stod(Value());
+            else if (argument == "--fok")
+                workload.fillOrKillRatio_ = std::stod(Value());
+            else if (argument == "--cross")
+                workload.crossRatio_ = std::stod(Value());
+            else if (argument == "--mid")
+                workload.midPrice_ = std::stoi(Value());
+            else if (argument == "--max-distance")
+                workload.maxDistance_ = std::stoi(Value());
+            else if (argument == "--exponent")
+                workload.distanceExponent_ = std::stod(Value());
+            else if (argument.starts_with("--") || !options.output_.empty())
+                throw std::invalid_argument("Unexpected argument: " + std::string{argument});
+            else
+                options.output_ = argument;
+        }
+
+        if (options.output_.empty())
+            throw std::invalid_argument("No output file given.");
+        if (workload.midPrice_ <= workload.maxDistance_ + 1)
+            throw std::invalid_argument("The mid price must exceed the maximum distance from the touch.");
+        return options;
+    }
+
+    const char* OrderTypeName(std::uint8_t orderType) {
+        switch (static_cast<OrderType>(orderType)) {
+            case OrderType::FillAndKill: return "FillAndKill";
+            case OrderType::FillOrKill: return "FillOrKill";
+            case OrderType::GoodForDay: return "GoodForDay";
+            case OrderType::Market: return "Market";
+            default: return "GoodTillCancel";
+        }
+    }
+
+    // Text files carry no arrival gaps
+    void WriteText(std::ostream& output, const OrderMessage& message) {
+        const char side = message.side_ == static_cast<std::uint8_t>(Side::Sell) ? 'S' : 'B';
+        switch (message.type_) {
+            case MessageType::NewOrder:
+                output << "A " << side << ' ' << OrderTypeName(message.orderType_) << ' ' << message.price_ << ' '
+                       << message.quantity_ << ' ' << message.orderId_ << '\n';
+                break;
+            case MessageType::ModifyOrder:
+                output << "M " << message.orderId_ << ' ' << side << ' ' << message.price_ << ' ' << message.quantity_ << '\n';
+                break;
+            default:
+                output << "C " << message.orderId_ << '\n';
+                break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    GeneratorOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        PrintUsage();
+        return 1;
+    }
+
+    try {
+        WorkloadGenerator generator{options.workload_};
+        std::filesystem::remove(options.output_);
+
+        if (options.binary_) {
+            JournalWriter journal{options.output_, JournalConfig{.sync_ = JournalSync::None}};
+            for (std::uint64_t index = 0; index < options.messages_; ++index)
+                journal.Append(generator.Next());
+            journal.Flush();
+        }
+        else {
+            std::vector<char> buffer(1 << 20);
+            std::ofstream file;
+            file.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            file.open(options.output_);
+            for (std::uint64_t index = 0; index < options.messages_; ++index)
+                WriteText(file, generator.Next());
+            if (!file.flush())
+                throw std::runtime_error("Cannot write " + options.output_.string());
+        }
+
+        std::cout << "Wrote " << options.messages_ << " messages to " << options.output_.string() << '\n';
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
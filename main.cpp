@@ -1,54 +1,260 @@
-#include "test_include.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-int main() {
-    InputHandle handle;
-    std::filesystem::path inputFilePath;
+#include "Orderbook.hpp"
+#include "CommandFile.hpp"
+#include "Journal.hpp"
 
-    std::cout << "Enter the path to the input file: ";
-    std::cin >> inputFilePath;
+namespace {
+    /**
+     * @struct ReplayListener
+     * @brief Counts the trades of a replay.
+     */
+    struct ReplayListener : BookListener {
+        std::uint64_t trades_{};
+        std::uint64_t volume_{};
 
+        void OnTrade(const Trade& trade) {
+            ++trades_;
+            volume_ += trade.GetBidTrade().quantity_;
+        }
+    };
+
+    /**
+     * @struct ReplayOptions
+     * @brief Command line of the replay tool.
+     */
+    struct ReplayOptions {
+        std::filesystem::path input_;
+        std::optional<bool> binary_;  ///< Detected from the file when not given.
+        bool pace_{};                 ///< Follow the recorded gaps of a binary workload.
+        double rate_{};               ///< Fixed messages per second; zero for as fast as possible.
+        std::size_t depth_{5};
+        std::size_t batch_{1};        ///< Commands applied per lock acquisition.
+    };
+
+    void PrintUsage() {
+        std::cerr << "Usage: orderbook-replay <command file> [options]\n"
+                     "  --format text|binary  Input format; detected from the file by default.\n"
+                     "  --pace                Replay a binary workload at its recorded message gaps.\n"
+                     "  --rate <msgs/sec>     Replay at a fixed rate.\n"
+                     "  --depth <levels>      Levels per side printed at the end (default 5).\n"
+                     "  --batch <commands>    Commands applied per lock acquisition (default 1).\n";
+    }
+
+    ReplayOptions ParseOptions(int argc, char** argv) {
+        ReplayOptions options;
+        for (int index = 1; index < argc; ++index) {
+            const std::string_view argument{argv[index]};
+            auto Value = [&]() -> std::string {
+                if (++index >= argc)
+                    throw std::invalid_argument(std::string{argument} + " needs a value.");
+                return argv[index];
+            };
+
+            if (argument == "--format") {
+                const auto format = Value();
+                if (format != "text" && format != "binary")
+                    throw std::invalid_argument("Unknown format: " + format);
+                options.binary_ = format == "binary";
+            }
+            else if (argument == "--pace")
+                options.pace_ = true;
+            else if (argument == "--rate")
+                options.rate_ = std::stod(Value());
+            else if (argument == "--depth")
+                options.depth_ = std::stoul(Value());
+            else if (argument == "--batch")
+                options.batch_ = std::max<std::size_t>(std::stoul(Value()), 1);
+            else if (argument.starts_with("--") || !options.input_.empty())
+                throw std::invalid_argument("Unexpected argument: " + std::string{argument});
+            else
+                options.input_ = argument;
+        }
+
+        if (options.input_.empty())
+            throw std::invalid_argument("No command file given.");
+        return options;
+    }
+
+    // Binary workloads are journals: they start with the journal magic
+    bool IsJournal(const std::filesystem::path& path) {
+        char magic[8]{};
+        std::ifstream file{path, std::ios::binary};
+        file.read(magic, sizeof(magic));
+        return file && std::memcmp(magic, "OBJOURNL", sizeof(magic)) == 0;
+    }
+
+    /**
+     * @class Pacer
+     * @brief Holds each message back until its scheduled time; spins for short waits, sleeps for long ones.
+     */
+    class Pacer {
+    public:
+        explicit Pacer(bool enabled) : enabled_{enabled}, start_{std::chrono::steady_clock::now()} {}
+
+        void WaitFor(std::chrono::nanoseconds offset) {
+            if (!enabled_)
+                return;
+            const auto due = start_ + offset;
+            while (true) {
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= due)
+                    return;
+                if (due - now > std::chrono::microseconds(200))
+                    std::this_thread::sleep_for(due - now - std::chrono::microseconds(100));
+            }
+        }
+
+    private:
+        bool enabled_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    void PrintLevels(const char* name, std::size_t count, const LevelInfos& top) {
+        std::cout << name << " levels: " << count << '\n';
+        for (const auto& level : top)
+            std::cout << "  " << level.price_ << " x " << level.quantity_ << '\n';
+    }
+
+    void PrintLatency(const char* name, const LatencySummary& summary) {
+        if (summary.count_ == 0)
+            return;
+        std::cout << "  " << name << ": n=" << summary.count_ << " p50=" << summary.p50_ << " p99=" << summary.p99_
+                  << " p99.9=" << summary.p999_ << " max=" << summary.max_ << " ns\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    ReplayOptions options;
     try {
-        // Get the updates and result from the file
-        auto [updates, result] = handle.GetInfos(inputFilePath);
-
-        Orderbook orderbook;
-        for (const auto& update : updates) {
-            switch (update.type_) {
-                case ActionType::Add: { //Adds new order
-                    const Trades& trades = orderbook.AddOrder(std::make_shared<Order>(
-                        update.orderType_,
-                        update.orderId_,
-                        update.side_,
-                        update.price_,
-                        update.quantity_
-                    ));
-                }
-                break;
-                case ActionType::Modify: { //Modify Existing Order
-                    const Trades& trades = orderbook.ModifyOrder(OrderModify(
-                        update.orderId_,
-                        update.side_,
-                        update.price_,
-                        update.quantity_
-                    ));
-                }
-                break;
-                case ActionType::Cancel: { //Cancel existing order
-                    orderbook.CancelOrder(update.orderId_);
+        options = ParseOptions(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        PrintUsage();
+        return 1;
+    }
+
+    try {
+        BasicOrderbook<ReplayListener> orderbook{OrderbookConfig{.startPruneThread_ = false}};
+        std::uint64_t messages{}, accepted{}, rejected{};
+        std::optional<CommandFileResult> result;
+
+        // Commands are buffered and applied --batch at a time under one lock
+        std::vector<Command> batch;
+        std::vector<CommandStatus> statuses;
+        batch.reserve(options.batch_);
+        auto ApplyBatch = [&]() {
+            orderbook.ProcessBatch(batch, statuses);
+            for (const auto status : statuses) {
+                if (status == CommandStatus::Accepted)
+                    ++accepted;
+                else
+                    ++rejected;
+            }
+            batch.clear();
+        };
+        auto Apply = [&](const Command& command) {
+            batch.push_back(command);
+            if (batch.size() == options.batch_)
+                ApplyBatch();
+        };
+
+        const bool binary = options.binary_.value_or(IsJournal(options.input_));
+        if (options.pace_ && !binary)
+            throw std::invalid_argument("--pace needs a binary workload; use --rate for text files.");
+
+        Pacer pacer{options.pace_ || options.rate_ > 0};
+        std::chrono::nanoseconds recorded{};
+        auto Schedule = [&]() {
+            return options.rate_ > 0
+                ? std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(messages) * 1e9 / options.rate_))
+                : recorded;
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        if (binary) {
+            JournalReader journal{options.input_};
+            for (const auto& message : journal.Records()) {
+                // A damaged record ends the replay, as Orderbook::Replay does: nothing after it can be trusted
+                if (!message.Intact()) {
+                    std::cerr << "Warning: record " << messages << " fails its checksum; replay stops there.\n";
+                    break;
                 }
-                break;
-                default:
-                    throw std::logic_error("Unsupported Update");
+                recorded +=std::chrono::microseconds(message.delay_);
+                pacer.WaitFor(Schedule());
+                ++messages;
+
+                // Expiries in a recorded journal replay as cancels
+                Command commands[2];
+                std::size_t count = 1;
+                if (message.type_ == MessageType::Expire)
+                    commands[0] = message.ToCommand();
+                else
+                    count = Decode(message, commands[0], commands[1]);
+                if (count == 0)
+                    ++rejected;
+                for (std::size_t index = 0; index < count; ++index)
+                    Apply(commands[index]);
             }
         }
-        //Output what was found vs what was expected
-        const auto& orderbookInfos = orderbook.GetOrderInfos();
-        std::cout << "Orderbook Size: " << orderbook.Size() << std::endl;
-        std::cout << "Bid Count: " << orderbookInfos.GetBids().size() << std::endl;
-        std::cout << "Ask Count: " << orderbookInfos.GetAsks().size() << std::endl;
-        std::cout << "Expected Total Orders: " << result.allCount_ << std::endl;
-        std::cout << "Expected Bid Orders: " << result.bidCount_ << std::endl;
-        std::cout << "Expected Ask Orders: " << result.askCount_ << std::endl;
+        else {
+            CommandFileReader file{options.input_};
+            result = file.Parse([&](const Command& command) {
+                pacer.WaitFor(Schedule());
+                ++messages;
+                Apply(command);
+            });
+        }
+        ApplyBatch();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const auto& listener = orderbook.GetListener();
+        const auto topLevels = orderbook.GetTopLevels(options.depth_);
+        const auto orderbookInfos = orderbook.GetOrderInfos();
+        std::cout << "Messages: " << messages << '\n'
+                  << "Elapsed: " << elapsed.count() << " s\n"
+                  << "Throughput: " << static_cast<std::uint64_t>(static_cast<double>(messages) / elapsed.count()) << " msgs/sec\n"
+                  << "Accepted: " << accepted << "  Rejected: " << rejected << '\n'
+                  << "Trades: " << listener.trades_ << "  Volume: " << listener.volume_ << '\n'
+                  << "Orderbook Size: " << orderbook.Size() << '\n';
+        PrintLevels("Bid", orderbookInfos.GetBids().size(), topLevels.GetBids());
+        PrintLevels("Ask", orderbookInfos.GetAsks().size(), topLevels.GetAsks());
+
+        // Only recorded in builds configured with ORDERBOOK_LATENCY_STATS
+        if constexpr (LatencyStats::Enabled) {
+            const auto latency = orderbook.GetLatencyStats();
+            constexpr const char* typeNames[]{"GoodTillCancel", "FillAndKill", "FillOrKill", "GoodForDay", "Market", "GoodTillDate", "Iceberg"};
+            std::cout << "Latency:\n";
+            PrintLatency("Add", latency.add_);
+            for (std::size_t type = 0; type < latency.addByType_.size(); ++type)
+                PrintLatency(typeNames[type], latency.addByType_[type]);
+            PrintLatency("Cancel", latency.cancel_);
+            PrintLatency("Modify", latency.modify_);
+            PrintLatency("Match", latency.match_);
+            PrintLatency("Lock wait", latency.lockWait_);
+        }
+
+        //Output what was expected, for test files
+        if (result) {
+            const bool match = orderbook.Size() == result->allCount_ &&
+                orderbookInfos.GetBids().size() == result->bidCount_ && orderbookInfos.GetAsks().size() == result->askCount_;
+            std::cout << "Expected Total Orders: " << result->allCount_ << '\n'
+                      << "Expected Bid Levels: " << result->bidCount_ << '\n'
+                      << "Expected Ask Levels: " << result->askCount_ << '\n'
+                      << "Result: " << (match ? "match" : "MISMATCH") << '\n';
+            return match ? 0 : 2;
+        }
 
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << std::endl;
@@ -57,4 +263,3 @@ int main() {
 
     return 0;
 }
-
@@ -13,14 +13,17 @@ private:
     const static inline std::filesystem::path TestFolder{"TestFiles"};
 public:
     const static inline std::filesystem::path TestFolderPath{Root / TestFolder};
+
+    /**
+     * @brief Replays a test file through a book and checks the expected result line.
+     * @param file The name of the test file to use.
+     * @param config Construction settings of the book under test.
+     */
+    static void RunTestFile(const char* fileName, const OrderbookConfig& config);
 };
 
-/**
- * @brief Tests the functionality of the Orderbook class.
- * @param file The name of the test file to use.
- */
-TEST_P(OrderbookTestFixture, OrderbookTestSuite) {
-    const auto file = OrderbookTestFixture::TestFolderPath / GetParam();
+void OrderbookTestFixture::RunTestFile(const char* fileName, const OrderbookConfig& config) {
+    const auto file = TestFolderPath / fileName;
 
     InputHandle handle;
     const auto [updates, result] = handle.GetInfos(file);
@@ -44,7 +47,7 @@ TEST_P(OrderbookTestFixture, OrderbookTestSuite) {
         );
     };
 
-    Orderbook orderbook;
+    Orderbook orderbook{config};
     for (const auto& update : updates) {
         switch (update.type_) {
             case ActionType::Add: {
@@ -70,6 +73,28 @@ TEST_P(OrderbookTestFixture, OrderbookTestSuite) {
     ASSERT_EQ(orderbookInfos.GetAsks().size(), result.askCount_);
 }
 
+/**
+ * @brief Tests the functionality of the Orderbook class.
+ * @param file The name of the test file to use.
+ */
+TEST_P(OrderbookTestFixture, OrderbookTestSuite) {
+    RunTestFile(GetParam(), OrderbookConfig{});
+}
+
+/**
+ * @class LadderOrderbookTestFixture
+ * @brief Runs the test files against a book with a dense price ladder.
+ */
+class LadderOrderbookTestFixture : public OrderbookTestFixture {};
+
+/**
+ * @brief Same files with a ladder whose band covers only part of the prices used.
+ * @param file The name of the test file to use.
+ */
+TEST_P(LadderOrderbookTestFixture, LadderOrderbookTestSuite) {
+    RunTestFile(GetParam(), OrderbookConfig{ .basePrice_ = 95, .tickSize_ = 1, .levelCount_ = 10 });
+}
+
 /**
  * @brief Instantiates the test suite with various test files.
  */
@@ -89,6 +114,1230 @@ INSTANTIATE_TEST_SUITE_P(
     })
 );
 
+/**
+ * @class PipelineOrderbookTestFixture
+ * @brief Runs the test files through an OrderbookPipeline instead of calling the book directly.
+ */
+class PipelineOrderbookTestFixture : public OrderbookTestFixture {};
+
+/**
+ * @brief Same files submitted as commands to the pipeline's matching thread.
+ * @param file The name of the test file to use.
+ */
+TEST_P(PipelineOrderbookTestFixture, PipelineOrderbookTestSuite) {
+    const auto file = TestFolderPath / GetParam();
+
+    InputHandle handle;
+    const auto [updates, result] = handle.GetInfos(file);
+
+    std::atomic<std::size_t> eventCount{};
+    OrderbookPipeline pipeline{OrderbookConfig{}, PipelineConfig{}, {
+        [&eventCount](const PipelineEvent&) { ++eventCount; }
+    }};
+
+    for (const auto& update : updates)
+        pipeline.Submit(ToCommand(update));
+    pipeline.Flush();
+
+    const auto& orderbook = pipeline.GetOrderbook();
+    const auto& orderbookInfos = orderbook.GetOrderInfos();
+    ASSERT_EQ(orderbook.Size(), result.allCount_);
+    ASSERT_EQ(orderbookInfos.GetBids().size(), result.bidCount_);
+    ASSERT_EQ(orderbookInfos.GetAsks().size(), result.askCount_);
+}
+
+/**
+ * @class EngineOrderbookTestFixture
+ * @brief Runs the test files on several instruments of a sharded MatchingEngine.
+ */
+class EngineOrderbookTestFixture : public OrderbookTestFixture {};
+
+/**
+ * @brief Same files replayed on two instruments owned by different shards, plus one unknown instrument.
+ * @param file The name of the test file to use.
+ */
+TEST_P(EngineOrderbookTestFixture, EngineOrderbookTestSuite) {
+    const auto file = TestFolderPath / GetParam();
+
+    InputHandle handle;
+    const auto [updates, result] = handle.GetInfos(file);
+
+    constexpr InstrumentId first = 10, second = 11, unknown = 12;
+    std::atomic<std::size_t> unknownCount{};
+    MatchingEngine engine{EngineConfig{.shardCount_ = 2}, [&unknownCount](InstrumentId, const PipelineEvent& event) {
+        if (event.status_ == CommandStatus::UnknownInstrument)
+            ++unknownCount;
+    }};
+    engine.AddInstrument(first, OrderbookConfig{});
+    engine.AddInstrument(second, OrderbookConfig{});
+    engine.Start();
+
+    for (const auto& update : updates) {
+        engine.Submit(first, ToCommand(update));
+        engine.Submit(second, ToCommand(update));
+        engine.Submit(unknown, ToCommand(update));
+    }
+    engine.Flush();
+
+    ASSERT_NE(engine.ShardOf(first), engine.ShardOf(second));
+    ASSERT_EQ(unknownCount.load(), updates.size());
+    for (const auto instrumentId : {first, second}) {
+        const auto& orderbook = *engine.GetOrderbook(instrumentId);
+        const auto& orderbookInfos = orderbook.GetOrderInfos();
+        ASSERT_EQ(orderbook.Size(), result.allCount_);
+        ASSERT_EQ(orderbookInfos.GetBids().size(), result.bidCount_);
+        ASSERT_EQ(orderbookInfos.GetAsks().size(), result.askCount_);
+    }
+}
+
+/**
+ * @brief Good-Till-Date orders leave at their own expiry and Good-For-Day orders at the session close;
+ * fills and modifies keep the expiry wheel consistent.
+ */
+TEST(OrderbookExpiryTest, ExpiresGoodTillDateAndGoodForDay) {
+    using namespace std::chrono;
+
+    const auto now = system_clock::now();
+    Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+
+    // Already expired: rejected
+    orderbook.AddOrder(Order{OrderType::GoodTillDate, 1, Side::Buy, 100, 10, now - hours(1)});
+    ASSERT_EQ(orderbook.Size(), 0);
+
+    orderbook.AddOrder(Order{OrderType::GoodTillDate, 2, Side::Buy, 100, 10, now + hours(1)});
+    orderbook.AddOrder(Order{OrderType::GoodTillDate, 3, Side::Buy, 99, 10, now + hours(3)});
+    orderbook.AddOrder(Order{OrderType::GoodTillDate, 4, Side::Sell, 110, 10, now + minutes(30)});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 5, Side::Sell, 112, 10});
+
+    // Fully fills order 4, which must not be expired later
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 6, Side::Buy, 110, 10});
+    // Moves order 3, keeping its expiry
+    orderbook.ModifyOrder(OrderModify{3, Side::Buy, 98, 10});
+    ASSERT_EQ(orderbook.Size(), 3);
+
+    ASSERT_EQ(orderbook.ExpireOrders(now + minutes(59)), 0);
+    ASSERT_EQ(orderbook.ExpireOrders(now + hours(2)), 1);
+    ASSERT_EQ(orderbook.ExpireOrders(now + hours(4)), 1);
+    ASSERT_EQ(orderbook.ExpireOrders(now + days(400)), 0);
+
+    const auto& orderbookInfos = orderbook.GetOrderInfos();
+    ASSERT_EQ(orderbook.Size(), 1);
+    ASSERT_EQ(orderbookInfos.GetBids().size(), 0);
+    ASSERT_EQ(orderbookInfos.GetAsks().size(), 1);
+
+    // The next session close is less than a day away
+    Orderbook dayOrderbook{OrderbookConfig{.startPruneThread_ = false}};
+    dayOrderbook.AddOrder(Order{OrderType::GoodForDay, 1, Side::Sell, 111, 10});
+    dayOrderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 112, 10});
+    ASSERT_EQ(dayOrderbook.ExpireOrders(now + days(2)), 1);
+    ASSERT_EQ(dayOrderbook.Size(), 1);
+}
+
+/**
+ * @brief An idle engine expires orders as their books come due, including a book whose deadline
+ * an add brought forward, and leaves the orders of books not yet due.
+ */
+TEST(OrderbookExpiryTest, EngineExpiresBooksAsTheyComeDue) {
+    using namespace std::chrono;
+
+    MatchingEngine engine{EngineConfig{}};
+    for (const InstrumentId instrumentId : {1, 2, 3})
+        engine.AddInstrument(instrumentId, OrderbookConfig{});
+    engine.Start();
+
+    const auto now = system_clock::now();
+    engine.Submit(1, Command::Add(Order{OrderType::GoodTillDate, 1, Side::Buy, 100, 10, now + milliseconds(20)}));
+    engine.Submit(2, Command::Add(Order{OrderType::GoodTillDate, 2, Side::Buy, 100, 10, now + hours(1)}));
+    engine.Submit(2, Command::Add(Order{OrderType::GoodTillDate, 3, Side::Buy, 99, 10, now + milliseconds(30)}));
+    engine.Submit(3, Command::Add(Order{OrderType::GoodTillDate, 4, Side::Sell, 110, 10, now + hours(1)}));
+    engine.Flush();
+
+    const auto giveUp = steady_clock::now() + seconds(5);
+    while ((engine.GetOrderbook(1)->Size() != 0 || engine.GetOrderbook(2)->Size() != 1) && steady_clock::now() < giveUp)
+        std::this_thread::sleep_for(milliseconds(1));
+
+    ASSERT_EQ(engine.GetOrderbook(1)->Size(), 0);
+    ASSERT_EQ(engine.GetOrderbook(2)->Size(), 1);
+    ASSERT_EQ(engine.GetOrderbook(3)->Size(), 1);
+}
+
+/**
+ * @brief Listener counting the book's events and mirroring its level aggregates.
+ */
+struct RecordingListener : BookListener {
+    std::size_t added_{}, cancelled_{}, traded_{};
+    std::map<std::pair<Side, Price>, Quantity> levels_;
+
+    void OnOrderAdded(const Order&) { ++added_; }
+    void OnOrderCancelled(const Order&) { ++cancelled_; }
+    void OnTrade(const Trade& trade) { traded_ += trade.GetBidTrade().quantity_; }
+    void OnLevelChanged(Side side, Price price, const LevelData& data) {
+        if (data.count_ == 0)
+            levels_.erase({side, price});
+        else
+            levels_[{side, price}] = data.quantity_;
+    }
+};
+
+/**
+ * @brief A book with a custom listener reports every add, cancel, trade and level change.
+ */
+TEST(OrderbookListenerTest, ReportsBookEvents) {
+    BasicOrderbook<RecordingListener> orderbook{OrderbookConfig{.startPruneThread_ = false}};
+
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 5});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 101, 7});
+    ASSERT_EQ(orderbook.AddOrder(Order{OrderType::FillAndKill, 4, Side::Sell, 100, 12}), CommandStatus::Accepted);
+    ASSERT_EQ(orderbook.CancelOrder(3), CommandStatus::Accepted);
+    ASSERT_EQ(orderbook.CancelOrder(3), CommandStatus::UnknownOrderId);
+
+    // The Fill-And-Kill order trades on arrival and never rests
+    const auto& listener = orderbook.GetListener();
+    ASSERT_EQ(listener.added_, 3);
+    ASSERT_EQ(listener.cancelled_, 1);
+    ASSERT_EQ(listener.traded_, 12);
+    ASSERT_EQ(listener.levels_.size(), 1);
+    ASSERT_EQ((listener.levels_.at({Side::Buy, 100})), 3);
+
+    const auto& orderbookInfos = orderbook.GetOrderInfos();
+    ASSERT_EQ(orderbookInfos.GetBids().size(), 1);
+    ASSERT_EQ(orderbookInfos.GetBids().front().quantity_, 3);
+    ASSERT_EQ(orderbookInfos.GetAsks().size(), 0);
+}
+
+/**
+ * @brief Aggressive orders trade before they are stored: only a residual that rests is added to the book.
+ */
+TEST(OrderbookListenerTest, MatchesBeforeInserting) {
+    BasicOrderbook<RecordingListener> orderbook{OrderbookConfig{.startPruneThread_ = false}};
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 101, 5});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 102, 5});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 103, 5});
+
+    // Sweeps two levels, the rest is dropped without ever resting
+    ASSERT_EQ(orderbook.AddOrder(Order{OrderType::FillAndKill, 4, Side::Buy, 102, 12}), CommandStatus::Accepted);
+    ASSERT_EQ(orderbook.GetListener().traded_, 10);
+    ASSERT_EQ(orderbook.GetListener().added_, 3);
+    ASSERT_EQ(orderbook.GetListener().cancelled_, 0);
+    ASSERT_FALSE(orderbook.GetBestBid());
+
+    // A market order takes everything, then rests at the worst price it could reach
+    ASSERT_EQ(orderbook.AddOrder(Order{5, Side::Buy, 8}), CommandStatus::Accepted);
+    ASSERT_EQ(orderbook.GetListener().traded_, 15);
+    ASSERT_EQ(orderbook.GetListener().added_, 4);
+    ASSERT_EQ(orderbook.GetBestBid()->price_, 103);
+    ASSERT_EQ(orderbook.GetBestBid()->quantity_, 3);
+    ASSERT_EQ(orderbook.Size(), 1);
+    ASSERT_EQ(orderbook.AddOrder(Order{6, Side::Buy, 8}), CommandStatus::NoLiquidity);
+
+    // Fully filled on arrival: no level is created for it
+    ASSERT_EQ(orderbook.AddOrder(Order{OrderType::GoodTillCancel, 7, Side::Sell, 100, 3}), CommandStatus::Accepted);
+    ASSERT_EQ(orderbook.Size(), 0);
+    ASSERT_EQ(orderbook.GetListener().added_, 4);
+    ASSERT_TRUE(orderbook.GetListener().levels_.empty());
+}
+
+/**
+ * @brief The cumulative-depth index agrees with summing the levels, on and off the ladder's band.
+ */
+TEST(OrderbookLiquidityTest, SumsDepthUpToLimit) {
+    WorkloadGenerator generator{WorkloadConfig{.seed_ = 7, .maxDistance_ = 20}};
+    // The band covers the prices near the mid only; the rest go to the overflow levels
+    Orderbook laddered{OrderbookConfig{.basePrice_ = 9'990, .tickSize_ = 1, .levelCount_ = 20, .startPruneThread_ = false}};
+    Orderbook mapped{OrderbookConfig{.startPruneThread_ = false}};
+
+    for (int step = 0; step < 4000; ++step) {
+        Command command, second;
+        if (Decode(generator.Next(), command, second) == 0)
+            continue;
+        ASSERT_EQ(laddered.ProcessCommand(command), mapped.ProcessCommand(command));
+        if (step % 100 != 0)
+            continue;
+
+        const auto infos = laddered.GetOrderInfos();
+        for (Price limit = 9'960; limit <= 10'040; ++limit) {
+            std::uint64_t bids = 0, asks = 0;
+            for (const auto& level : infos.GetBids())
+                bids += level.price_ >= limit ? level.quantity_ : 0;
+            for (const auto& level : infos.GetAsks())
+                asks += level.price_ <= limit ? level.quantity_ : 0;
+            ASSERT_EQ(laddered.AvailableLiquidity(Side::Sell, limit), bids);
+            ASSERT_EQ(laddered.AvailableLiquidity(Side::Buy, limit), asks);
+            ASSERT_EQ(mapped.AvailableLiquidity(Side::Sell, limit), bids);
+            ASSERT_EQ(mapped.AvailableLiquidity(Side::Buy, limit), asks);
+        }
+    }
+}
+
+/**
+ * @brief The off-grid depth index keeps its prefix sums as prices come and go, in both price orders.
+ */
+TEST(OrderbookLiquidityTest, CompressedDepthSumsInPriceOrder) {
+    std::mt19937 random{11};
+    CompressedDepth<std::greater<Price>> bids;
+    CompressedDepth<std::less<Price>> asks;
+    std::map<Price, std::uint64_t> quantities;
+
+    for (int step = 0; step < 20000; ++step) {
+        const Price price = static_cast<Price>(random() % 200) - 100;
+        auto& quantity = quantities[price];
+        // Take away at most what is there, so the quantity of a price can return to zero
+        const auto delta = random() % 2 == 0 ? std::int64_t(random() % 50) : -std::int64_t(random() % (quantity + 1));
+        quantity += delta;
+        bids.Add(price, delta);
+        asks.Add(price, delta);
+        if (quantity == 0)
+            quantities.erase(price);
+        ASSERT_EQ(bids.Size(), quantities.size());
+        if (step % 500 != 0)
+            continue;
+
+        for (Price limit = -102; limit <= 102; ++limit) {
+            std::uint64_t atOrAbove = 0, atOrBelow = 0;
+            for (const auto& [level, held] : quantities) {
+                atOrAbove += level >= limit ? held : 0;
+                atOrBelow += level <= limit ? held : 0;
+            }
+            ASSERT_EQ(bids.SumTo(limit), atOrAbove);
+            ASSERT_EQ(asks.SumTo(limit), atOrBelow);
+        }
+    }
+}
+
+/**
+ * @brief Partial fills and in-place cuts reach both the queue entry matching walks and the full order.
+ */
+TEST(OrderbookModifyTest, KeepsQueueEntryInStep) {
+    Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 10});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 100, 10});
+
+    // Order 1 is left with 6, then cut to 4 without losing its place
+    orderbook.AddOrder(Order{OrderType::FillAndKill, 3, Side::Buy, 100, 4});
+    ASSERT_TRUE(orderbook.ModifyOrder(OrderModify{1, Side::Sell, 100, 4}).empty());
+
+    const auto trades = orderbook.AddOrder(Order{OrderType::FillAndKill, 4, Side::Buy, 100, 9});
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].GetAskTrade().orderId_, 1);
+    ASSERT_EQ(trades[0].GetAskTrade().quantity_, 4);
+    ASSERT_EQ(trades[1].GetAskTrade().orderId_, 2);
+    ASSERT_EQ(trades[1].GetAskTrade().quantity_, 5);
+
+    // Moving order 2 takes its remaining 5 off the level, as written back to its full record
+    const auto asks = orderbook.GetOrderInfos().GetAsks();
+    ASSERT_EQ(asks.size(), 1);
+    ASSERT_EQ(asks[0].quantity_, 5);
+    ASSERT_TRUE(orderbook.ModifyOrder(OrderModify{2, Side::Sell, 101, 5}).empty());
+    ASSERT_EQ(orderbook.GetBestAsk()->price_, 101);
+    ASSERT_EQ(orderbook.GetBestAsk()->quantity_, 5);
+    ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().size(), 1);
+}
+
+/**
+ * @brief Pinned, busy-polling drivers on huge-page memory, which falls back to regular pages
+ * when the host has none reserved, match the same flow as a plain book.
+ */
+TEST(HugePageArenaTest, PlacesDriverMemoryOnMatchingNode) {
+    HugePageArena arena{NodeOfCore(0)};
+    auto* small = static_cast<char*>(arena.Allocate(100, 64));
+    auto* large = static_cast<char*>(arena.Allocate(3 * HugePageSize, 4096));
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(small) % 64, 0);
+    std::fill_n(small, 100, 'a');
+    std::fill_n(large, 3 * HugePageSize, 'b');
+    ASSERT_EQ(arena.Reserved(), 4 * HugePageSize);
+    ASSERT_LE(arena.HugeTlbReserved(), arena.Reserved());
+
+    WorkloadGenerator generator{WorkloadConfig{.seed_ = 11, .maxDistance_ = 20}};
+    Commands commands;
+    while (commands.size() < 2000) {
+        Command command, second;
+        if (Decode(generator.Next(), command, second) > 0)
+            commands.push_back(command);
+    }
+
+    const OrderbookConfig bookConfig{.basePrice_ = 9'900, .tickSize_ = 1, .levelCount_ = 200, .startPruneThread_ = false};
+    Orderbook expected{bookConfig};
+    for (const auto& command : commands)
+        expected.ProcessCommand(command);
+
+    std::atomic<std::size_t> eventCount{};
+    {
+        const PipelineConfig config{.matchingCore_ = 0, .consumerCores_ = {0}, .idle_ = IdleStrategy::BusyPoll, .hugePages_ = true};
+        OrderbookPipeline pipeline{bookConfig, config, {[&eventCount](const PipelineEvent&) { ++eventCount; }}};
+        ASSERT_EQ(pipeline.GetArena()->Node(), NodeOfCore(0));
+        for (const auto& command : commands)
+            pipeline.Submit(command);
+        pipeline.Flush();
+
+        ASSERT_GT(pipeline.GetArena()->Reserved(), 0);
+        ASSERT_EQ(pipeline.GetOrderbook().GetOrderInfos().GetBids().size(), expected.GetOrderInfos().GetBids().size());
+        ASSERT_EQ(pipeline.GetOrderbook().GetOrderInfos().GetAsks().size(), expected.GetOrderInfos().GetAsks().size());
+        ASSERT_EQ(pipeline.GetOrderbook().GetSummary().trades_, expected.GetSummary().trades_);
+    }
+    ASSERT_EQ(eventCount.load(), commands.size() + expected.GetSummary().trades_);
+
+    MatchingEngine engine{EngineConfig{.shardCores_ = {0}, .idle_ = IdleStrategy::BusyPoll, .hugePages_ = true}};
+    engine.AddInstrument(1, bookConfig);
+    engine.Start();
+    for (const auto& command : commands)
+        engine.Submit(1, command);
+    engine.Flush();
+    ASSERT_EQ(engine.GetOrderbook(1)->Size(), expected.Size());
+    ASSERT_EQ(engine.GetOrderbook(1)->GetSummary().trades_, expected.GetSummary().trades_);
+}
+
+/**
+ * @brief Random streams leave the optimised book, in map and ladder mode, in step with the reference model.
+ */
+TEST(OrderbookFuzzTest, MatchesReferenceBook) {
+    for (std::uint64_t seed = 1; seed <= 3; ++seed) {
+        const auto commands = GenerateFuzzCommands(FuzzConfig{.seed_ = seed, .commands_ = 3'000});
+        const auto mapResult = RunDifferential(commands);
+        ASSERT_TRUE(mapResult) << "seed " << seed << ": " << mapResult.reason_;
+        const auto ladderResult = RunDifferential(commands, OrderbookConfig{.basePrice_ = 992, .tickSize_ = 1, .levelCount_ = 17});
+        ASSERT_TRUE(ladderResult) << "seed " << seed << ": " << ladderResult.reason_;
+        ASSERT_EQ(ladderResult.agreed_, commands.size());
+    }
+
+    // Agreeing streams have nothing to shrink
+    const Commands commands{
+        Command{CommandType::Add, OrderType::GoodTillCancel, 1, Side::Buy, 100, 10},
+        Command::Cancel(7),
+        Command{CommandType::Add, OrderType::GoodTillCancel, 2, Side::Sell, 101, 5},
+        Command{CommandType::Add, OrderType::GoodTillCancel, 3, Side::Sell, 100, 4},
+    };
+    ASSERT_EQ(RunDifferential(commands).agreed_, commands.size());
+    ASSERT_TRUE(ShrinkDivergence(commands).empty());
+}
+
+/**
+ * @brief The journal of a random stream, with its refused commands and expiries, replays into the book that wrote it.
+ */
+TEST(OrderbookFuzzTest, JournalReplaysRandomStreams) {
+    for (std::uint64_t seed = 1; seed <= 3; ++seed) {
+        const auto commands = GenerateFuzzCommands(FuzzConfig{.seed_ = seed, .commands_ = 3'000});
+        const auto mapResult = RunJournalRoundTrip(commands);
+        ASSERT_TRUE(mapResult) << "seed " << seed << ": " << mapResult.reason_;
+        const auto ladderResult = RunJournalRoundTrip(commands, OrderbookConfig{.basePrice_ = 992, .tickSize_ = 1, .levelCount_ = 17});
+        ASSERT_TRUE(ladderResult) << "seed " << seed << ": " << ladderResult.reason_;
+    }
+}
+
+/**
+ * @brief An Iceberg order shows one slice at a time and rejoins the back of its queue with the next,
+ * while depth reports count only the slice and Fill-Or-Kill checks see the whole order.
+ */
+TEST(OrderbookIcebergTest, ReplenishesSliceAtBackOfQueue) {
+    const auto snapshotPath = std::filesystem::temp_directory_path() / "orderbook-iceberg-test.snapshot";
+    const OrderbookConfig config{.basePrice_ = 95, .tickSize_ = 1, .levelCount_ = 10, .startPruneThread_ = false};
+    Orderbook orderbook{config};
+    orderbook.AddOrder(Order{1, Side::Buy, 100, 100, 10});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 5});
+    ASSERT_EQ(orderbook.GetOrderInfos().GetBids()[0].quantity_, 15);
+    ASSERT_EQ(orderbook.AvailableLiquidity(Side::Sell, 100), 105);
+
+    // The slice trades away and order 1 goes behind order 2 with a new one, under the same id
+    auto trades = orderbook.AddOrder(Order{OrderType::FillAndKill, 3, Side::Sell, 100, 12});
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].GetBidTrade().orderId_, 1);
+    ASSERT_EQ(trades[0].GetBidTrade().quantity_, 10);
+    ASSERT_EQ(trades[1].GetBidTrade().orderId_, 2);
+    ASSERT_EQ(trades[1].GetBidTrade().quantity_, 2);
+    ASSERT_EQ(orderbook.GetBestBid()->quantity_, 13);
+    ASSERT_EQ(orderbook.Size(), 2);
+
+    // A cut takes the reserve first, keeping the slice and the place
+    ASSERT_TRUE(orderbook.ModifyOrder(OrderModify{1, Side::Buy, 100, 14}).empty());
+    ASSERT_EQ(orderbook.GetBestBid()->quantity_, 13);
+    ASSERT_EQ(orderbook.AvailableLiquidity(Side::Sell, 100), 17);
+    ASSERT_EQ(orderbook.ProcessCommand(Command::Add(Order{OrderType::FillOrKill, 4, Side::Sell, 100, 18})), CommandStatus::CannotFullyFill);
+
+    // One sell sweeps order 2, then order 1 slice after slice
+    trades = orderbook.AddOrder(Order{OrderType::FillAndKill, 5, Side::Sell, 100, 7});
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[1].GetBidTrade().orderId_, 1);
+    ASSERT_EQ(trades[1].GetBidTrade().quantity_, 4);
+    ASSERT_EQ(orderbook.GetBestBid()->quantity_, 6);
+
+    // A snapshot brings the order back with what was left of its slice
+    {
+        auto snapshot = orderbook.Snapshot(snapshotPath);
+        ASSERT_TRUE(snapshot.Wait());
+    }
+    Orderbook restored{config};
+    restored.Restore(SnapshotReader{snapshotPath});
+    ASSERT_EQ(restored.GetBestBid()->quantity_, 6);
+    ASSERT_EQ(restored.AvailableLiquidity(Side::Sell, 100), 10);
+    trades = restored.AddOrder(Order{OrderType::FillOrKill, 6, Side::Sell, 100, 10});
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].GetBidTrade().quantity_, 6);
+    ASSERT_EQ(trades[1].GetBidTrade().quantity_, 4);
+    ASSERT_EQ(restored.Size(), 0);
+    std::filesystem::remove(snapshotPath);
+
+    // The display quantity travels in the message, and must fit within the order
+    Command command, second;
+    auto message = OrderMessage::FromCommand(Command::Add(Order{7, Side::Sell, 101, 50, 5}));
+    ASSERT_EQ(Decode(message, command, second), 1);
+    ASSERT_EQ(command.orderType_, OrderType::Iceberg);
+    ASSERT_EQ(command.displayQuantity_, 5);
+    message.expiry_ = 51;
+    ASSERT_EQ(Decode(message, command, second), 0);
+}
+
+/**
+ * @brief An Iceberg whose display quantity is zero or above its quantity is turned away by the book as by Decode.
+ */
+TEST(OrderbookIcebergTest, RejectsInvalidDisplayQuantity) {
+    const auto snapshotPath = std::filesystem::temp_directory_path() / "orderbook-iceberg-reject-test.snapshot";
+    Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+    ASSERT_EQ(orderbook.ProcessCommand(Command::Add(Order{1, Side::Buy, 100, 10, 0})), CommandStatus::InvalidDisplayQuantity);
+    ASSERT_EQ(orderbook.ProcessCommand(Command::Add(Order{2, Side::Buy, 100, 10, 11})), CommandStatus::InvalidDisplayQuantity);
+    ASSERT_TRUE(orderbook.AddOrder(Order{3, Side::Buy, 100, 10, 0}).empty());
+    ASSERT_EQ(orderbook.Size(), 0);
+
+    // A display quantity equal to the order is a plain slice, and the snapshot restores it
+    ASSERT_EQ(orderbook.ProcessCommand(Command::Add(Order{4, Side::Buy, 100, 10, 10})), CommandStatus::Accepted);
+    {
+        auto snapshot = orderbook.Snapshot(snapshotPath);
+        ASSERT_TRUE(snapshot.Wait());
+    }
+    Orderbook restored{OrderbookConfig{.startPruneThread_ = false}};
+    restored.Restore(SnapshotReader{snapshotPath});
+    ASSERT_EQ(restored.GetBestBid()->quantity_, 10);
+    std::filesystem::remove(snapshotPath);
+}
+
+/**
+ * @brief The book and Decode share one set of rules, so a new order gets the same answer through either.
+ */
+TEST(OrderbookValidationTest, RejectsWhatDecodeRejects) {
+    Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+    const std::pair<Command, CommandStatus> cases[] = {
+        {Command::Add(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 0}), CommandStatus::InvalidQuantity},
+        {Command::Add(Order{2, Side::Buy, 0}), CommandStatus::InvalidQuantity},
+        {Command::Add(Order{OrderType::GoodTillDate, 3, Side::Buy, 100, 5, Timestamp{}}), CommandStatus::MissingExpiry},
+        {Command::Add(Order{4, Side::Buy, 100, 5, 6}), CommandStatus::InvalidDisplayQuantity},
+        {Command::Add(Order{OrderType::GoodTillCancel, 5, Side::Buy, 100, 5}), CommandStatus::Accepted},
+        {Command::Modify(OrderModify{5, Side::Buy, 100, 0}), CommandStatus::InvalidQuantity},
+    };
+
+    for (const auto& [command, status] : cases) {
+        Command decoded, second;
+        ASSERT_EQ(orderbook.ProcessCommand(command), status);
+        ASSERT_EQ(Decode(OrderMessage::FromCommand(command), decoded, second), status == CommandStatus::Accepted ? 1 : 0);
+    }
+    ASSERT_EQ(orderbook.Size(), 1);
+}
+
+namespace {
+    // Home slot of an id in a 64-slot table, hashed as OrderIdIndex does
+    std::size_t HomeOf(OrderId orderId) { return (orderId * 0x9E3779B97F4A7C15ull) >> 58; }
+
+    // The first ids that hash to a home slot; all below the window opened at 1'000'000, so they go to the table
+    std::vector<OrderId> IdsAt(std::size_t home, std::size_t count) {
+        std::vector<OrderId> ids;
+        for (OrderId orderId = 1; ids.size() < count; ++orderId)
+            if (HomeOf(orderId) == home)
+                ids.push_back(orderId);
+        return ids;
+    }
+}
+
+/**
+ * @brief Erasing from a probe run shifts back the ids that may move, and leaves those at their home.
+ */
+TEST(OrderIdIndexTest, ShiftsRunBackOnErase) {
+    OrderIdIndex index;
+    index.Insert(1'000'000, 0);
+    const auto first = IdsAt(20, 2);
+    const auto second = IdsAt(21, 1)[0];
+    // first[0] at 20, second at its home 21, first[1] pushed to 22
+    index.Insert(first[0], 1);
+    index.Insert(second, 2);
+    index.Insert(first[1], 3);
+    auto stats = index.GetStats();
+    ASSERT_EQ(stats.hashSize_, 3);
+    ASSERT_EQ(stats.hashCapacity_, 64);
+    ASSERT_EQ(stats.maxProbeLength_, 2);
+
+    ASSERT_EQ(index.Erase(first[0]), 1);
+    ASSERT_EQ(index.Erase(first[0]), InvalidOrderHandle);
+    ASSERT_EQ(index.Find(second), 2);
+    ASSERT_EQ(index.Find(first[1]), 3);
+    stats = index.GetStats();
+    ASSERT_EQ(stats.hashSize_, 2);
+    ASSERT_EQ(stats.maxProbeLength_, 0);
+    ASSERT_EQ(index.Size(), 3);
+}
+
+/**
+ * @brief A run that wraps past the last slot is probed and shifted back across the end of the table.
+ */
+TEST(OrderIdIndexTest, WrapsAroundTableEnd) {
+    OrderIdIndex index;
+    index.Insert(1'000'000, 0);
+    const auto last = IdsAt(63, 2);
+    const auto first = IdsAt(0, 1)[0];
+    // last[0] at 63, last[1] wrapped to 0, first pushed to 1
+    index.Insert(last[0], 1);
+    index.Insert(last[1], 2);
+    index.Insert(first, 3);
+    ASSERT_EQ(index.Find(first), 3);
+    auto stats = index.GetStats();
+    ASSERT_EQ(stats.maxProbeLength_, 1);
+    ASSERT_DOUBLE_EQ(stats.averageProbeLength_, 2.0 / 3.0);
+
+    ASSERT_EQ(index.Erase(last[0]), 1);
+    ASSERT_EQ(index.Find(last[1]), 2);
+    ASSERT_EQ(index.Find(first), 3);
+    stats = index.GetStats();
+    ASSERT_EQ(stats.maxProbeLength_, 0);
+    ASSERT_DOUBLE_EQ(stats.averageProbeLength_, 0.0);
+}
+
+/**
+ * @brief The table doubles before it passes three quarters full, and Reserve sizes it up front; no id is lost either way.
+ */
+TEST(OrderIdIndexTest, GrowsUnderLoad) {
+    OrderIdIndex index;
+    index.Insert(1'000'000, 0);
+    for (OrderId orderId = 1; orderId <= 1000; ++orderId)
+        index.Insert(orderId * 7, static_cast<OrderHandle>(orderId));
+
+    auto stats = index.GetStats();
+    ASSERT_EQ(stats.size_, 1001);
+    ASSERT_EQ(stats.denseSize_, 1);
+    ASSERT_EQ(stats.hashSize_, 1000);
+    ASSERT_EQ(stats.hashCapacity_, 2048);
+    ASSERT_DOUBLE_EQ(stats.loadFactor_, 1000.0 / 2048.0);
+
+    index.Reserve(5000);
+    ASSERT_EQ(index.GetStats().hashCapacity_, 8192);
+    for (OrderId orderId = 1; orderId <= 1000; orderId += 2)
+        ASSERT_EQ(index.Erase(orderId * 7), orderId);
+    for (OrderId orderId = 1; orderId <= 1000; ++orderId)
+        ASSERT_EQ(index.Find(orderId * 7), orderId % 2 == 0 ? orderId : InvalidOrderHandle);
+    ASSERT_EQ(index.GetStats().hashSize_, 500);
+}
+
+/**
+ * @brief The book reports its index figures: ids in order fill the window, an outlying one goes to the table.
+ */
+TEST(OrderIdIndexTest, ReportsBookIndexStats) {
+    Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+    for (OrderId orderId = 1; orderId <= 10; ++orderId)
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, orderId, Side::Buy, 100, 1});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1'000'000'000, Side::Sell, 110, 1});
+
+    auto stats = orderbook.GetOrderIndexStats();
+    ASSERT_EQ(stats.size_, 11);
+    ASSERT_EQ(stats.denseSize_, 10);
+    ASSERT_EQ(stats.denseCapacity_, 4096);
+    ASSERT_EQ(stats.hashSize_, 1);
+    ASSERT_EQ(stats.hashCapacity_, 64);
+    ASSERT_DOUBLE_EQ(stats.loadFactor_, 1.0 / 64.0);
+    ASSERT_EQ(stats.maxProbeLength_, 0);
+
+    orderbook.CancelOrder(1'000'000'000);
+    orderbook.CancelOrder(1);
+    stats = orderbook.GetOrderIndexStats();
+    ASSERT_EQ(stats.size_, 9);
+    ASSERT_EQ(stats.denseSize_, 9);
+    ASSERT_EQ(stats.hashSize_, 0);
+    ASSERT_DOUBLE_EQ(stats.loadFactor_, 0.0);
+}
+
+/**
+ * @brief Top-of-book, top-N and depth deltas follow the incrementally maintained level aggregates.
+ */
+TEST(OrderbookDepthTest, PublishesTopLevelsAndChanges) {
+    Orderbook orderbook{OrderbookConfig{.depthLogCapacity_ = 8, .startPruneThread_ = false}};
+    ASSERT_FALSE(orderbook.GetBestBid());
+
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 99, 5});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Buy, 98, 5});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Sell, 102, 7});
+
+    const auto snapshot = orderbook.GetTopLevels(2);
+    ASSERT_EQ(snapshot.GetBids().size(), 2);
+    ASSERT_EQ(snapshot.GetBids().back().price_, 99);
+    ASSERT_EQ(snapshot.GetAsks().size(), 1);
+    ASSERT_EQ(orderbook.GetBestBid()->quantity_, 10);
+    ASSERT_EQ(orderbook.GetBestAsk()->price_, 102);
+
+    // Partial fill of the best bid, then its removal: one change for the level.
+    // The filled sell never rests, so no ask level changes.
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 5, Side::Sell, 100, 4});
+    orderbook.CancelOrder(1);
+
+    LevelChanges changes;
+    const auto sequence = orderbook.GetDepthChanges(snapshot.GetSequence(), changes);
+    ASSERT_TRUE(sequence);
+    ASSERT_EQ(changes.size(), 1);
+    ASSERT_EQ(changes[0].price_, 100);
+    ASSERT_EQ(changes[0].side_, Side::Buy);
+    ASSERT_EQ(changes[0].data_.count_, 0);
+    ASSERT_EQ(orderbook.GetBestBid()->price_, 99);
+
+    ASSERT_TRUE(orderbook.GetDepthChanges(*sequence, changes));
+    ASSERT_TRUE(changes.empty());
+
+    // The log only keeps the last 8 changes
+    for (OrderId orderId = 10; orderId < 20; ++orderId)
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, orderId, Side::Sell, 110, 1});
+    ASSERT_FALSE(orderbook.GetDepthChanges(*sequence, changes));
+    ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().back().quantity_, 10);
+}
+
+/**
+ * @brief Replaying the journal of accepted commands and expiries rebuilds the same book.
+ */
+TEST(OrderbookJournalTest, ReplaysAcceptedCommands) {
+    using namespace std::chrono;
+
+    const auto now = system_clock::now();
+    const auto path = std::filesystem::temp_directory_path() / "orderbook-journal-test.bin";
+    std::filesystem::remove(path);
+
+    LevelInfos expectedBids, expectedAsks;
+    {
+        JournalWriter journal{path};
+        Orderbook orderbook{OrderbookConfig{.journal_ = &journal, .startPruneThread_ = false}};
+
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10});
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 99, 10});
+        orderbook.AddOrder(Order{OrderType::GoodTillDate, 3, Side::Buy, 98, 10, now + minutes(5)});
+        orderbook.AddOrder(Order{OrderType::GoodTillDate, 4, Side::Sell, 105, 10, now + hours(5)});
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 5, Side::Sell, 100, 4});
+        orderbook.AddOrder(Order{OrderType::GoodForDay, 7, Side::Sell, 110, 10});
+        orderbook.ModifyOrder(OrderModify{2, Side::Buy, 97, 8});
+        orderbook.CancelOrder(1);
+        // Rejected: not journaled
+        orderbook.CancelOrder(1);
+        orderbook.AddOrder(Order{OrderType::FillOrKill, 6, Side::Sell, 90, 100});
+        ASSERT_EQ(orderbook.ExpireOrders(now + minutes(10)), 1);
+
+        journal.Flush();
+        ASSERT_EQ(journal.Written(), 9);
+        expectedBids = orderbook.GetOrderInfos().GetBids();
+        expectedAsks = orderbook.GetOrderInfos().GetAsks();
+    }
+
+    const auto sessionClose = ExpiryWheel::ToTick(*NextSessionClose(now));
+    {
+        JournalReader journal{path};
+        ASSERT_EQ(journal.Records().size(), 9);
+        ASSERT_EQ(journal.Records().back().type_, MessageType::Expire);
+        // The Good-For-Day order carries the close it was given
+        ASSERT_EQ(journal.Records()[5].expiry_, sessionClose);
+
+        Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+        ASSERT_EQ(orderbook.Replay(journal), 9);
+        ASSERT_THROW(orderbook.Replay(journal), std::logic_error);
+
+        const auto& orderbookInfos = orderbook.GetOrderInfos();
+        ASSERT_EQ(orderbook.Size(), 3);
+        ASSERT_EQ(orderbookInfos.GetBids().size(), expectedBids.size());
+        ASSERT_EQ(orderbookInfos.GetBids().front().price_, 97);
+        ASSERT_EQ(orderbookInfos.GetAsks().front().quantity_, expectedAsks.front().quantity_);
+        // The Good-For-Day ask expires at the recorded close, the Good-Till-Date ask at its own expiry
+        const auto dayAskRests = [&orderbook] {
+            const auto asks = orderbook.GetOrderInfos().GetAsks();
+            return !asks.empty() && asks.back().price_ == 110;
+        };
+        orderbook.ExpireOrders(ExpiryWheel::ToTimestamp(sessionClose - 1));
+        ASSERT_TRUE(dayAskRests());
+        orderbook.ExpireOrders(ExpiryWheel::ToTimestamp(sessionClose));
+        ASSERT_FALSE(dayAskRests());
+        orderbook.ExpireOrders(now + hours(6));
+        ASSERT_TRUE(orderbook.GetOrderInfos().GetAsks().empty());
+        ASSERT_EQ(orderbook.Size(), 1);
+    }
+
+    // A reopened journal is appended to; a record that does not decode ends a replay
+    {
+        JournalWriter journal{path, JournalConfig{.core_ = 0}};
+        auto empty = OrderMessage::FromCommand(Command::Add(Order{OrderType::GoodTillCancel, 8, Side::Buy, 100, 1}));
+        empty.quantity_ = 0;
+        journal.Append(empty);
+        journal.Append(OrderMessage::FromCommand(Command::Cancel(2)));
+    }
+    ASSERT_EQ(JournalReader{path}.Records().size(), 11);
+    ASSERT_EQ(Orderbook{OrderbookConfig{.startPruneThread_ = false}}.Replay(JournalReader{path}), 9);
+
+    // So does a record whose checksum no longer matches
+    {
+        std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(static_cast<std::streamoff>(4 * sizeof(JournalRecord) + offsetof(OrderMessage, price_)));
+        file.put('\x7f');
+    }
+    ASSERT_FALSE(JournalReader{path}.Records()[3].Intact());
+    ASSERT_EQ(Orderbook{OrderbookConfig{.startPruneThread_ = false}}.Replay(JournalReader{path}), 3);
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Commands Decode refuses are refused by the book too, so they never reach the journal and cannot cut a replay short.
+ */
+TEST(OrderbookJournalTest, JournalsOnlyWhatReplays) {
+    const auto path = std::filesystem::temp_directory_path() / "orderbook-journal-roundtrip-test.bin";
+    const Command refused[] = {
+        Command::Modify(OrderModify{1, Side::Buy, 100, 0}),
+        Command::Add(Order{OrderType::GoodTillCancel, 9, Side::Buy, 100, 0}),
+        Command::Add(Order{OrderType::GoodTillDate, 9, Side::Buy, 100, 5, Timestamp{}}),
+    };
+
+    for (const auto& command : refused) {
+        std::filesystem::remove(path);
+        Orderbook live{OrderbookConfig{.startPruneThread_ = false}};
+        {
+            JournalWriter journal{path};
+            Orderbook journaled{OrderbookConfig{.journal_ = &journal, .startPruneThread_ = false}};
+            for (auto* book : {&live, &journaled}) {
+                book->AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10});
+                book->AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 99, 10});
+                book->ProcessCommand(command);
+                book->CancelOrder(2);
+                book->AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 101, 7});
+            }
+            journal.Flush();
+        }
+
+        JournalReader journal{path};
+        ASSERT_EQ(journal.Records().size(), 4);
+        Orderbook replayed{OrderbookConfig{.startPruneThread_ = false}};
+        ASSERT_EQ(replayed.Replay(journal), 4);
+        ASSERT_EQ(replayed.Size(), live.Size());
+        ASSERT_EQ(replayed.GetOrderInfos().GetBids(), live.GetOrderInfos().GetBids());
+        ASSERT_EQ(replayed.GetOrderInfos().GetAsks(), live.GetOrderInfos().GetAsks());
+    }
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief A snapshot plus the journal after it restores the same levels, queue priority and expiries.
+ */
+TEST(OrderbookSnapshotTest, RestoresSnapshotAndJournalTail) {
+    using namespace std::chrono;
+
+    const auto now = system_clock::now();
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto journalPath = directory / "orderbook-snapshot-test.journal";
+    const auto snapshotPath = directory / "orderbook-snapshot-test.snapshot";
+    std::filesystem::remove(journalPath);
+    // Part of the prices fall outside the ladder's band
+    const OrderbookConfig config{.basePrice_ = 95, .tickSize_ = 1, .levelCount_ = 10, .startPruneThread_ = false};
+
+    LevelInfos expectedBids, expectedAsks;
+    {
+        JournalWriter journal{journalPath};
+        auto journalConfig = config;
+        journalConfig.journal_ = &journal;
+        Orderbook orderbook{journalConfig};
+
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10});
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 5});
+        orderbook.AddOrder(Order{OrderType::GoodTillDate, 3, Side::Buy, 90, 10, now + hours(1)});
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Sell, 120, 10});
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 5, Side::Sell, 101, 10});
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 6, Side::Sell, 100, 4});
+
+        auto snapshot = orderbook.Snapshot(snapshotPath);
+        // Not in the snapshot: replayed from the journal
+        orderbook.AddOrder(Order{OrderType::GoodTillCancel, 7, Side::Sell, 102, 3});
+        orderbook.CancelOrder(4);
+        ASSERT_TRUE(snapshot.Wait());
+
+        journal.Flush();
+        expectedBids = orderbook.GetOrderInfos().GetBids();
+        expectedAsks = orderbook.GetOrderInfos().GetAsks();
+    }
+
+    SnapshotReader snapshot{snapshotPath};
+    ASSERT_EQ(snapshot.Header().journalPosition_, 6);
+    ASSERT_EQ(snapshot.Levels().size(), 4);
+    ASSERT_EQ(snapshot.Orders().size(), 5);
+
+    JournalReader journal{journalPath};
+    Orderbook orderbook{config};
+    ASSERT_EQ(orderbook.Restore(snapshot, &journal), 2);
+    ASSERT_THROW(orderbook.Restore(snapshot), std::logic_error);
+
+    const auto& orderbookInfos = orderbook.GetOrderInfos();
+    ASSERT_EQ(orderbook.Size(), 5);
+    ASSERT_EQ(orderbookInfos.GetBids().size(), expectedBids.size());
+    ASSERT_EQ(orderbookInfos.GetAsks().size(), expectedAsks.size());
+    for (std::size_t index = 0; index < expectedBids.size(); ++index)
+        ASSERT_EQ(orderbookInfos.GetBids()[index].quantity_, expectedBids[index].quantity_);
+    for (std::size_t index = 0; index < expectedAsks.size(); ++index)
+        ASSERT_EQ(orderbookInfos.GetAsks()[index].price_, expectedAsks[index].price_);
+
+    // The partly filled order 1 is still ahead of order 2
+    const auto trades = orderbook.AddOrder(Order{OrderType::FillAndKill, 8, Side::Sell, 100, 7});
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].GetBidTrade().orderId_, 1);
+    ASSERT_EQ(trades[0].GetBidTrade().quantity_, 6);
+
+    ASSERT_EQ(orderbook.ExpireOrders(now + hours(2)), 1);
+    std::filesystem::remove(journalPath);
+    std::filesystem::remove(snapshotPath);
+}
+
+/**
+ * @brief The mapped parser cuts tokens across 64-byte blocks, tolerates CRLF and repeated blanks,
+ * and streams commands in file order.
+ */
+TEST(CommandFileTest, StreamsCommandsAcrossBlocks) {
+    const auto path = std::filesystem::temp_directory_path() / "orderbook-command-file-test.txt";
+    {
+        std::ofstream file{path, std::ios::binary};
+        for (OrderId orderId = 1; orderId <= 100; ++orderId)
+            file << "A " << (orderId % 2 ? "B" : "S") << "  GoodTillCancel " << 1000 + orderId << " 7 " << orderId << (orderId % 3 ? "\n" : "\r\n");
+        file << "M 4 B 90 3\n\nC 5\t\nA S Market 0 1 101\nR 99 49 50";
+    }
+
+    std::vector<Command> commands;
+    CommandFileReader file{path};
+    const auto result = file.Parse([&commands](const Command& command) { commands.push_back(command); });
+
+    ASSERT_TRUE(result);
+    ASSERT_EQ(result->bidCount_, 49);
+    ASSERT_EQ(commands.size(), 103);
+    for (OrderId orderId = 1; orderId <= 100; ++orderId) {
+        const auto& command = commands[orderId - 1];
+        ASSERT_EQ(command.orderId_, orderId);
+        ASSERT_EQ(command.price_, 1000 + orderId);
+        ASSERT_EQ(command.side_, orderId % 2 ? Side::Buy : Side::Sell);
+    }
+    ASSERT_EQ(commands[100].type_, CommandType::Modify);
+    ASSERT_EQ(commands[100].quantity_, 3);
+    ASSERT_EQ(commands[101].type_, CommandType::Cancel);
+    ASSERT_EQ(commands[102].orderType_, OrderType::Market);
+
+    {
+        std::ofstream file{path, std::ios::binary};
+        file << "A B GoodTillCancel 100 -5 1\n";
+    }
+    ASSERT_THROW(CommandFileReader{path}.Parse([](const Command&) {}), std::logic_error);
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Binary messages are validated, applied and answered with acks, rejects and executions.
+ */
+TEST(ProtocolTest, DispatchesMessagesAndReportsExecutions) {
+    std::vector<ReportMessage> reports;
+    auto output = [&reports](const ReportMessage& report) { reports.push_back(report); };
+    BasicOrderbook<ExecutionReporter<decltype(output)>> orderbook{OrderbookConfig{.startPruneThread_ = false}, ExecutionReporter{output}};
+
+    std::vector<OrderMessage> messages{
+        OrderMessage::FromCommand(Command::Add(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10})),
+        OrderMessage::FromCommand(Command::Add(Order{OrderType::GoodTillCancel, 2, Side::Sell, 105, 10})),
+        OrderMessage::FromCommand(Command::Add(Order{OrderType::FillAndKill, 3, Side::Sell, 100, 4})),
+        OrderMessage::FromCommand(Command::Cancel(9)),
+        OrderMessage{.type_ = MessageType::Expire, .orderId_ = 1},
+        OrderMessage{.type_ = MessageType::MassCancel, .side_ = BothSides},
+    };
+    std::vector<std::byte> input(messages.size() * sizeof(OrderMessage) + 5);
+    std::memcpy(input.data(), messages.data(), messages.size() * sizeof(OrderMessage));
+
+    ASSERT_EQ(DispatchMessages(input, orderbook, output), messages.size() * sizeof(OrderMessage));
+    ASSERT_EQ(reports.size(), 8);
+    ASSERT_EQ(reports[2].type_, MessageType::Execution);
+    ASSERT_EQ(reports[2].orderId_, 1);
+    ASSERT_EQ(reports[2].matchOrderId_, 3);
+    ASSERT_EQ(reports[2].quantity_, 4);
+    ASSERT_EQ(reports[3].side_, static_cast<std::uint8_t>(Side::Sell));
+    ASSERT_EQ(reports[4].type_, MessageType::Ack);
+    ASSERT_EQ(reports[4].orderId_, 3);
+    ASSERT_EQ(reports[5].status_, static_cast<std::uint8_t>(CommandStatus::UnknownOrderId));
+    ASSERT_EQ(reports[6].status_, static_cast<std::uint8_t>(CommandStatus::InvalidMessage));
+    ASSERT_EQ(reports[7].type_, MessageType::Ack);
+    ASSERT_EQ(orderbook.Size(), 0);
+}
+
+/**
+ * @brief Cutting quantity keeps queue priority, raising it loses priority, and a new price
+ * moves the same record and matches it.
+ */
+TEST(OrderbookModifyTest, AmendsInPlace) {
+    Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 10});
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Buy, 100, 10});
+
+    // Order 1 stays first; order 2 goes behind order 3
+    ASSERT_TRUE(orderbook.ModifyOrder(OrderModify{1, Side::Buy, 100, 4}).empty());
+    ASSERT_TRUE(orderbook.ModifyOrder(OrderModify{2, Side::Buy, 100, 12}).empty());
+    ASSERT_EQ(orderbook.GetBestBid()->quantity_, 26);
+
+    auto trades = orderbook.AddOrder(Order{OrderType::FillAndKill, 4, Side::Sell, 100, 16});
+    ASSERT_EQ(trades.size(), 3);
+    ASSERT_EQ(trades[0].GetBidTrade().orderId_, 1);
+    ASSERT_EQ(trades[0].GetBidTrade().quantity_, 4);
+    ASSERT_EQ(trades[1].GetBidTrade().orderId_, 3);
+    ASSERT_EQ(trades[2].GetBidTrade().orderId_, 2);
+    ASSERT_EQ(trades[2].GetBidTrade().quantity_, 2);
+
+    // Moving across the spread matches straight away
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 5, Side::Sell, 105, 5});
+    trades = orderbook.ModifyOrder(OrderModify{2, Side::Buy, 105, 8});
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].GetAskTrade().orderId_, 5);
+    ASSERT_EQ(orderbook.Size(), 1);
+    ASSERT_EQ(orderbook.GetBestBid()->price_, 105);
+    ASSERT_EQ(orderbook.GetBestBid()->quantity_, 3);
+    ASSERT_FALSE(orderbook.GetBestAsk());
+
+    ASSERT_EQ(orderbook.ModifyOrder(OrderModify{9, Side::Buy, 105, 8}).size(), 0);
+    // A modify to nothing is refused, as Decode refuses it; a cancel takes the order out
+    ASSERT_EQ(orderbook.ProcessCommand(Command::Modify(OrderModify{2, Side::Buy, 105, 0})), CommandStatus::InvalidQuantity);
+    ASSERT_EQ(orderbook.Size(), 1);
+    ASSERT_EQ(orderbook.CancelOrder(2), CommandStatus::Accepted);
+    ASSERT_EQ(orderbook.Size(), 0);
+    ASSERT_TRUE(orderbook.GetOrderInfos().GetBids().empty());
+}
+
+/**
+ * @brief A batch gives the same statuses, trades and book as the same commands applied one by one,
+ * and reports each touched level once.
+ */
+TEST(OrderbookBatchTest, MatchesSequentialProcessing) {
+    WorkloadGenerator generator{WorkloadConfig{.seed_ = 3, .maxDistance_ = 20}};
+    Commands commands;
+    while (commands.size() < 5000) {
+        Command command, second;
+        const auto count = Decode(generator.Next(), command, second);
+        if (count > 0)
+            commands.push_back(command);
+    }
+
+    Orderbook sequential{OrderbookConfig{.startPruneThread_ = false}};
+    std::vector<CommandStatus> statuses;
+    Trades trades;
+    for (const auto& command : commands) {
+        statuses.push_back(sequential.ProcessCommand(command));
+        const auto& commandTrades = sequential.GetListener().GetTrades();
+        trades.insert(trades.end(), commandTrades.begin(), commandTrades.end());
+        sequential.GetListener().GetTrades().clear();
+    }
+
+    Orderbook batched{OrderbookConfig{.startPruneThread_ = false}};
+    BatchResults results;
+    for (std::size_t begin = 0; begin < commands.size(); begin += 64)
+        batched.ProcessBatch(std::span<const Command>{commands}.subspan(begin, std::min<std::size_t>(64, commands.size() - begin)), results);
+    ASSERT_EQ(results.statuses_.size(), commands.size() % 64);
+
+    // The last batch on its own, compared command by command
+    const auto last = commands.size() - results.statuses_.size();
+    for (std::size_t index = 0; index < results.statuses_.size(); ++index)
+        ASSERT_EQ(results.statuses_[index], statuses[last + index]);
+
+    ASSERT_EQ(batched.Size(), sequential.Size());
+    const auto expected = sequential.GetOrderInfos(), actual = batched.GetOrderInfos();
+    ASSERT_EQ(actual.GetBids().size(), expected.GetBids().size());
+    ASSERT_EQ(actual.GetAsks().size(), expected.GetAsks().size());
+    for (std::size_t index = 0; index < expected.GetBids().size(); ++index) {
+        ASSERT_EQ(actual.GetBids()[index].price_, expected.GetBids()[index].price_);
+        ASSERT_EQ(actual.GetBids()[index].quantity_, expected.GetBids()[index].quantity_);
+    }
+    for (std::size_t index = 0; index < expected.GetAsks().size(); ++index)
+        ASSERT_EQ(actual.GetAsks()[index].quantity_, expected.GetAsks()[index].quantity_);
+
+    // Per-command trades of a fresh batch line up with the sequential run
+    Orderbook replayed{OrderbookConfig{.startPruneThread_ = false}};
+    replayed.ProcessBatch(commands, results);
+    ASSERT_EQ(results.statuses_, statuses);
+    ASSERT_EQ(results.trades_.size(), trades.size());
+    std::size_t traded{};
+    for (std::size_t index = 0; index < commands.size(); ++index)
+        traded += results.TradesOf(index).size();
+    ASSERT_EQ(traded, trades.size());
+    for (std::size_t index = 0; index < trades.size(); ++index) {
+        ASSERT_EQ(results.trades_[index].GetBidTrade().orderId_, trades[index].GetBidTrade().orderId_);
+        ASSERT_EQ(results.trades_[index].GetAskTrade().quantity_, trades[index].GetAskTrade().quantity_);
+    }
+
+    // Levels are reported once per batch
+    BasicOrderbook<RecordingListener> recorded{OrderbookConfig{.startPruneThread_ = false}};
+    const Commands adds{
+        Command::Add(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10}),
+        Command::Add(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 5}),
+        Command::Add(Order{OrderType::GoodTillCancel, 3, Side::Sell, 101, 7}),
+        Command::Cancel(3),
+    };
+    const auto sequence = recorded.GetOrderInfos().GetSequence();
+    recorded.ProcessBatch(adds, statuses);
+    ASSERT_EQ(recorded.GetOrderInfos().GetSequence(), sequence + 2);
+    ASSERT_EQ(recorded.GetListener().levels_.size(), 1);
+    ASSERT_EQ((recorded.GetListener().levels_.at({Side::Buy, 100})), 15);
+
+    // Commands after the batch report their levels as they happen again
+    recorded.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 99, 3});
+    ASSERT_EQ(recorded.GetOrderInfos().GetSequence(), sequence + 3);
+    ASSERT_EQ((recorded.GetListener().levels_.at({Side::Buy, 99})), 3);
+    LevelChanges changes;
+    ASSERT_EQ(recorded.GetDepthChanges(sequence + 2, changes), sequence + 3);
+    ASSERT_EQ(changes.size(), 1);
+
+    // A batch cut short by a throwing command drops what it held back rather than reporting it on unwind
+    auto unsupported = Command::Cancel(4);
+    unsupported.type_ = static_cast<CommandType>(0x7f);
+    const Commands broken{Command::Add(Order{OrderType::GoodTillCancel, 5, Side::Buy, 98, 2}), unsupported};
+    ASSERT_THROW(recorded.ProcessBatch(broken, statuses), std::logic_error);
+    ASSERT_FALSE(recorded.GetListener().levels_.contains({Side::Buy, 98}));
+    recorded.AddOrder(Order{OrderType::GoodTillCancel, 6, Side::Buy, 97, 1});
+    ASSERT_EQ((recorded.GetListener().levels_.at({Side::Buy, 97})), 1);
+}
+
+/**
+ * @brief Readers on other threads see consistent, uncrossed summaries in version order while the
+ * pipeline's matching thread keeps writing.
+ */
+TEST(OrderbookSummaryTest, PublishesConsistentTopOfBook) {
+    OrderbookPipeline pipeline{OrderbookConfig{}, PipelineConfig{}};
+    const auto& orderbook = pipeline.GetOrderbook();
+    ASSERT_EQ(orderbook.GetSummary().version_, 0);
+
+    std::atomic<bool> done{};
+    std::atomic<std::size_t> inconsistent{}, reads{};
+    std::vector<std::thread> readers;
+    for (int reader = 0; reader < 2; ++reader) {
+        readers.emplace_back([&] {
+            std::uint64_t lastVersion{};
+            while (!done.load(std::memory_order_acquire)) {
+                const auto summary = orderbook.GetSummary();
+                if (summary.version_ < lastVersion ||
+                    (summary.bidLevels_ != 0 && summary.askLevels_ != 0 && summary.bestBid_ >= summary.bestAsk_) ||
+                    (summary.orders_ == 0 && summary.bidLevels_ + summary.askLevels_ != 0))
+                    ++inconsistent;
+                lastVersion = summary.version_;
+                ++reads;
+            }
+        });
+    }
+
+    WorkloadGenerator generator{WorkloadConfig{.seed_ = 5, .maxDistance_ = 20}};
+    std::size_t submitted{};
+    while (submitted < 20000) {
+        Command command, second;
+        if (Decode(generator.Next(), command, second) == 0)
+            continue;
+        pipeline.Submit(command);
+        ++submitted;
+    }
+    pipeline.Flush();
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers)
+        reader.join();
+
+    ASSERT_EQ(inconsistent.load(), 0);
+    ASSERT_GT(reads.load(), 0);
+
+    const auto summary = orderbook.GetSummary();
+    const auto& orderbookInfos = orderbook.GetOrderInfos();
+    ASSERT_EQ(summary.version_, submitted);
+    ASSERT_EQ(summary.orders_, orderbook.Size());
+    ASSERT_GT(summary.trades_, 0);
+    ASSERT_EQ(summary.lastBidTrade_.quantity_, summary.lastAskTrade_.quantity_);
+    ASSERT_EQ(summary.bidLevels_, orderbookInfos.GetBids().size());
+    ASSERT_EQ(summary.askLevels_, orderbookInfos.GetAsks().size());
+    ASSERT_EQ(summary.bestBid_, orderbookInfos.GetBids().front().price_);
+    ASSERT_EQ(summary.bestAskQuantity_, orderbookInfos.GetAsks().front().quantity_);
+}
+
+/**
+ * @brief Histogram percentiles land within a sub-bucket of the recorded values; the book's report
+ * counts each operation when instrumentation is compiled in and stays empty otherwise.
+ */
+TEST(LatencyStatsTest, RecordsPercentilesPerOperation) {
+    LatencyHistogram histogram;
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+        histogram.Record(value);
+    histogram.Record(100000);
+
+    const auto summary = histogram.Summarize(1.0);
+    ASSERT_EQ(summary.count_, 1001);
+    ASSERT_GE(summary.p50_, 500);
+    ASSERT_LE(summary.p50_, 500 + 500 / LatencyHistogram::SubBuckets);
+    ASSERT_GE(summary.p99_, 990);
+    ASSERT_EQ(summary.max_, 100000);
+    histogram.Reset();
+    ASSERT_EQ(histogram.Summarize(1.0).count_, 0);
+
+    Orderbook orderbook{OrderbookConfig{.startPruneThread_ = false}};
+    orderbook.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10});
+    orderbook.AddOrder(Order{OrderType::FillAndKill, 2, Side::Sell, 100, 4});
+    orderbook.ModifyOrder(OrderModify{1, Side::Buy, 99, 6});
+    orderbook.CancelOrder(1);
+
+    const auto report = orderbook.GetLatencyStats();
+    const std::uint64_t expected = LatencyStats::Enabled ? 1 : 0;
+    ASSERT_EQ(report.add_.count_, 2 * expected);
+    ASSERT_EQ(report.addByType_[static_cast<std::size_t>(OrderType::FillAndKill)].count_, expected);
+    ASSERT_EQ(report.modify_.count_, expected);
+    ASSERT_EQ(report.cancel_.count_, expected);
+    ASSERT_EQ(report.match_.count_, 3 * expected);
+    ASSERT_EQ(report.lockWait_.count_, 4 * expected);
+
+    orderbook.ResetLatencyStats();
+    ASSERT_EQ(orderbook.GetLatencyStats().add_.count_, 0);
+}
+
+/**
+ * @brief Instantiates the ladder suite with the well-formed test files.
+ */
+INSTANTIATE_TEST_SUITE_P(
+    Tests,
+    LadderOrderbookTestFixture,
+    googletest::ValuesIn({
+        "Match_GoodTillCancel.txt",
+        "Match_FillAndKill.txt",
+        "Match_FillOrKill_Hit.txt",
+        "Match_FillOrKill_Miss.txt",
+        "Cancel_Success.txt",
+        "Modify_Side.txt",
+        "Match_Market.txt"
+    })
+);
+
+/**
+ * @brief Instantiates the pipeline suite with the well-formed test files.
+ */
+INSTANTIATE_TEST_SUITE_P(
+    Tests,
+    PipelineOrderbookTestFixture,
+    googletest::ValuesIn({
+        "Match_GoodTillCancel.txt",
+        "Match_FillAndKill.txt",
+        "Match_FillOrKill_Hit.txt",
+        "Match_FillOrKill_Miss.txt",
+        "Cancel_Success.txt",
+        "Modify_Side.txt",
+        "Match_Market.txt"
+    })
+);
+
+/**
+ * @brief Instantiates the engine suite with the well-formed test files.
+ */
+INSTANTIATE_TEST_SUITE_P(
+    Tests,
+    EngineOrderbookTestFixture,
+    googletest::ValuesIn({
+        "Match_GoodTillCancel.txt",
+        "Match_FillAndKill.txt",
+        "Match_FillOrKill_Hit.txt",
+        "Match_FillOrKill_Miss.txt",
+        "Cancel_Success.txt",
+        "Modify_Side.txt",
+        "Match_Market.txt"
+    })
+);
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();